@@ -0,0 +1,68 @@
+#include "archetype/allocator.h"
+#include "bench.h"
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <utility>
+
+// Node heavy container work through run time chosen allocators: the
+// archetype allocators behind stl_allocator against their std::pmr
+// counterparts. Each operation builds a map of 1000 keys and a list of
+// 1000 values, then destroys them. Built as C++17 for std::pmr.
+
+const int keys = 1000;
+
+template <typename Alloc>
+void work(const Alloc & alloc) {
+  using pair_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<
+      std::pair<const int, int>>;
+  std::map<int, int, std::less<int>, pair_alloc> m{pair_alloc(alloc)};
+  std::list<int, Alloc> l(alloc);
+  for (int i = 0; i < keys; i++) {
+    m[(i * 7919) % keys] = i;
+    l.push_back(i);
+  }
+  bench::do_not_optimize(m);
+  bench::do_not_optimize(l);
+}
+
+template <typename F>
+double per_run(F f) {
+  return bench::ns_per_op(2000, [&](std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) { f(); }
+  });
+}
+
+int main() {
+  bench::header("map and list of 1000 elements, build and destroy");
+
+  bench::report("std::allocator", per_run([] { work(std::allocator<int>()); }));
+
+  bench::report("std::pmr::monotonic_buffer_resource", per_run([] {
+    std::pmr::monotonic_buffer_resource r;
+    work(std::pmr::polymorphic_allocator<int>(&r));
+  }));
+  bench::report("archetype::monotonic_arena", per_run([] {
+    archetype::monotonic_arena arena;
+    work(archetype::stl_allocator<int>(arena));
+  }));
+
+  std::pmr::unsynchronized_pool_resource pool_resource;
+  bench::report("std::pmr::unsynchronized_pool_resource", per_run([&] {
+    work(std::pmr::polymorphic_allocator<int>(&pool_resource));
+  }));
+  archetype::size_class_pool pool;
+  bench::report("archetype::size_class_pool", per_run([&] {
+    work(archetype::stl_allocator<int>(pool));
+  }));
+
+  bench::report("std::pmr::new_delete_resource", per_run([] {
+    work(std::pmr::polymorphic_allocator<int>(std::pmr::new_delete_resource()));
+  }));
+  archetype::thread_cache cache;
+  bench::report("archetype::thread_cache", per_run([&] {
+    work(archetype::stl_allocator<int>(cache));
+  }));
+
+  return 0;
+}
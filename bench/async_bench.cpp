@@ -0,0 +1,85 @@
+#include "archetype/archetype.h"
+#include "archetype/async.h"
+#include "bench.h"
+#include <cstdio>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Throughput of calls into a single threaded object from several producer
+// threads, a mutex guarded view against an async_view on an executor
+
+ARCHETYPE_DEFINE(accumulator, (ARCHETYPE_METHOD(int, add, int)))
+
+struct counter {
+  int total = 0;
+  int add(int x) { return total += x; }
+};
+
+template <typename Produce>
+double time_producers(unsigned producers, std::size_t calls, Produce produce) {
+  return bench::ns_per_op(producers * calls, [&](std::size_t) {
+    std::vector<std::thread> threads;
+    for (unsigned p = 0; p < producers; p++) {
+      threads.emplace_back([&] { produce(calls); });
+    }
+    for (auto & t : threads) { t.join(); }
+  }, 3);
+}
+
+// Runs the executor on its own thread while f runs
+template <typename F>
+double with_consumer(archetype::executor & exec, F f) {
+  std::atomic<bool> done(false);
+  std::thread consumer([&] {
+    while (!done.load(std::memory_order_acquire)) {
+      if (exec.run_pending() == 0) { std::this_thread::yield(); }
+    }
+    exec.run_pending();
+  });
+  double ns = f();
+  done.store(true, std::memory_order_release);
+  consumer.join();
+  return ns;
+}
+
+int main() {
+  const std::size_t calls = 200000;
+
+  for (unsigned producers = 1; producers <= 4; producers *= 2) {
+    char title[64];
+    std::snprintf(title, sizeof(title), "%u producer thread(s)", producers);
+    bench::header(title);
+
+    counter c;
+    accumulator::view guarded(c);
+    std::mutex m;
+    bench::report("mutex guarded accumulator::view",
+                  time_producers(producers, calls, [&](std::size_t n) {
+                    for (std::size_t i = 0; i < n; i++) {
+                      std::lock_guard<std::mutex> lock(m);
+                      guarded.add(1);
+                    }
+                  }));
+
+    archetype::executor exec(4096);
+    archetype::async_view<accumulator> async(c, exec);
+    bench::report("archetype::async_view, use_future",
+                  with_consumer(exec, [&] {
+                    return time_producers(producers, calls, [&](std::size_t n) {
+                      for (std::size_t i = 0; i < n; i++) { async.add(1); }
+                    });
+                  }));
+
+    archetype::async_view<accumulator, archetype::fire_and_forget> posted(c, exec);
+    bench::report("archetype::async_view, fire_and_forget",
+                  with_consumer(exec, [&] {
+                    return time_producers(producers, calls, [&](std::size_t n) {
+                      for (std::size_t i = 0; i < n; i++) { posted.add(1); }
+                    });
+                  }));
+  }
+
+  return 0;
+}
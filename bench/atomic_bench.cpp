@@ -0,0 +1,78 @@
+#include "archetype/archetype.h"
+#include "archetype/atomic.h"
+#include "bench.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Read path cost of a rebindable view: a plain view, a mutex guarded view,
+// std::atomic_load of a shared_ptr held view, and atomic_view, with and
+// without a writer rebinding it every 100us
+
+ARCHETYPE_DEFINE(accumulator, (ARCHETYPE_METHOD(int, add, int)))
+
+struct counter {
+  int total = 0;
+  int add(int x) { return total += x; }
+};
+
+template <typename Call>
+double time_reads(std::size_t n, Call call) {
+  return bench::ns_per_op(n, [&](std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) { call(static_cast<int>(i)); }
+    bench::clobber();
+  });
+}
+
+// Runs rebind every 100us on another thread while f runs
+template <typename Rebind, typename F>
+double with_writer(Rebind rebind, F f) {
+  std::atomic<bool> done(false);
+  std::thread writer([&] {
+    for (int i = 0; !done.load(std::memory_order_relaxed); i++) {
+      rebind(i);
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  });
+  double ns = f();
+  done = true;
+  writer.join();
+  return ns;
+}
+
+int main() {
+  const std::size_t n = 50000000;
+  counter a, b;
+
+  bench::header("calls through a rebindable binding");
+
+  accumulator::view plain(a);
+  bench::do_not_optimize(plain);
+  bench::report("accumulator::view, not rebindable",
+                time_reads(n, [&](int x) { plain.add(x); }));
+
+  std::mutex m;
+  accumulator::view guarded(a);
+  bench::report("mutex guarded accumulator::view", time_reads(n, [&](int x) {
+    std::lock_guard<std::mutex> lock(m);
+    guarded.add(x);
+  }));
+
+  std::shared_ptr<accumulator::view> shared = std::make_shared<accumulator::view>(a);
+  bench::report("std::atomic_load of shared_ptr<view>", time_reads(n, [&](int x) {
+    std::atomic_load(&shared)->add(x);
+  }));
+
+  archetype::atomic_view<accumulator> rebindable(a);
+  bench::report("archetype::atomic_view",
+                time_reads(n, [&](int x) { rebindable.add(x); }));
+
+  bench::report("archetype::atomic_view, rebinding every 100us",
+                with_writer([&](int i) { rebindable.store(i & 1 ? a : b); }, [&] {
+                  return time_reads(n, [&](int x) { rebindable.add(x); });
+                }));
+
+  return 0;
+}
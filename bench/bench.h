@@ -0,0 +1,61 @@
+#ifndef __ARCHETYPE_BENCH_H__
+#define __ARCHETYPE_BENCH_H__
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+// Minimal timing helpers shared by the benchmarks
+namespace bench {
+
+  // Stops the compiler from optimising away a value, or from assuming
+  // anything about it afterwards
+  template <typename T>
+  inline void do_not_optimize(T & value) {
+    asm volatile("" : "+m"(value) : : "memory");
+  }
+
+  inline void clobber() { asm volatile("" : : : "memory"); }
+
+  // Best of several runs, in nanoseconds per operation. f(n) performs n
+  // operations.
+  template <typename F>
+  double ns_per_op(std::size_t n, F f, int runs = 5) {
+    double best = 0;
+    for (int r = 0; r < runs; r++) {
+      auto start = std::chrono::steady_clock::now();
+      f(n);
+      auto end = std::chrono::steady_clock::now();
+      double ns = std::chrono::duration<double, std::nano>(end - start).count();
+      if (r == 0 || ns < best) { best = ns; }
+    }
+    return best / static_cast<double>(n);
+  }
+
+  inline void report(const char * name, double ns_per_op) {
+    std::printf("%-48s %10.3f ns/op\n", name, ns_per_op);
+  }
+
+  // Best of several runs, in MB per second. f() processes bytes bytes.
+  template <typename F>
+  double mb_per_s(std::size_t bytes, F f, int runs = 5) {
+    double ns = ns_per_op(bytes, [&](std::size_t) { f(); }, runs);
+    return 1e3 / ns;
+  }
+
+  inline void report_rate(const char * name, double mb_per_s) {
+    std::printf("%-48s %10.1f MB/s\n", name, mb_per_s);
+  }
+
+  // Operations per second from nanoseconds per operation
+  inline void report_per_s(const char * name, double ns_per_op) {
+    std::printf("%-48s %10.1f M/s\n", name, 1e3 / ns_per_op);
+  }
+
+  inline void header(const char * title) {
+    std::printf("\n%s\n", title);
+  }
+
+} // namespace bench
+
+#endif //__ARCHETYPE_BENCH_H__
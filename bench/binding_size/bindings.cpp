@@ -0,0 +1,12 @@
+#include "shapes.h"
+
+#ifdef BINDING_SIZE_EXTERN
+ARCHETYPE_INSTANTIATE_BINDING(shape, polygon<0>)
+ARCHETYPE_INSTANTIATE_BINDING(shape, polygon<1>)
+ARCHETYPE_INSTANTIATE_BINDING(shape, polygon<2>)
+ARCHETYPE_INSTANTIATE_BINDING(shape, polygon<3>)
+ARCHETYPE_INSTANTIATE_BINDING(shape, polygon<4>)
+ARCHETYPE_INSTANTIATE_BINDING(shape, polygon<5>)
+ARCHETYPE_INSTANTIATE_BINDING(shape, polygon<6>)
+ARCHETYPE_INSTANTIATE_BINDING(shape, polygon<7>)
+#endif
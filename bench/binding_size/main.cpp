@@ -0,0 +1,7 @@
+#include "shapes.h"
+#include <cstdio>
+
+int main() {
+  std::printf("%f\n", scene_a() + scene_b() + scene_c() + scene_d());
+  return 0;
+}
@@ -0,0 +1,25 @@
+#!/bin/sh
+# Usage: report.sh <label> <executable> <object files...>
+#
+# Prints the code size of the object files and the executable, and the
+# bytes and count of the symbols binding types to the archetype, the
+# vtables, make_vtable, bind and the method stubs it instantiates.
+
+label=$1
+exe=$2
+shift 2
+
+# bytes and count of the binding symbols in the given files
+bindings() {
+  nm -C -S -t d --defined-only "$@" 2>/dev/null |
+    grep -E 'make_vtable<|::bind<|bound_vtable<|::vtablet' |
+    awk '{ bytes += $2; n++ } END { printf "%8d bytes in %4d symbols", bytes, n }'
+}
+
+text() {
+  size -t "$@" | tail -n 1 | awk '{ print $1 }'
+}
+
+printf '%s\n' "$label"
+printf '  objects     text %8d, bindings %s\n' "$(text "$@")" "$(bindings "$@")"
+printf '  executable  text %8d, bindings %s\n' "$(text "$exe")" "$(bindings "$exe")"
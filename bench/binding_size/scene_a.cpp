@@ -0,0 +1,3 @@
+#include "shapes.h"
+
+double scene_a() { return scene<1>(); }
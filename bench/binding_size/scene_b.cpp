@@ -0,0 +1,3 @@
+#include "shapes.h"
+
+double scene_b() { return scene<2>(); }
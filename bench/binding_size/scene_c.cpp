@@ -0,0 +1,3 @@
+#include "shapes.h"
+
+double scene_c() { return scene<3>(); }
@@ -0,0 +1,3 @@
+#include "shapes.h"
+
+double scene_d() { return scene<4>(); }
@@ -0,0 +1,59 @@
+#ifndef __BINDING_SIZE_SHAPES_H__
+#define __BINDING_SIZE_SHAPES_H__
+
+#include "archetype/archetype.h"
+
+// An archetype and eight types bound to it from every scene TU. Built
+// with BINDING_SIZE_EXTERN the bindings are only instantiated in
+// bindings.cpp.
+
+ARCHETYPE_DEFINE(shape, (ARCHETYPE_METHOD(double, area),
+                         ARCHETYPE_METHOD(double, perimeter),
+                         ARCHETYPE_METHOD(void, scale, double),
+                         ARCHETYPE_METHOD(void, move, double, double),
+                         ARCHETYPE_METHOD(int, sides),
+                         ARCHETYPE_METHOD(const char *, name)))
+
+template <int K>
+struct polygon {
+  double x = 0, y = 0, r = K + 1;
+  double area() { return r * r * (K + 3) * 0.5; }
+  double perimeter() { return r * (K + 3); }
+  void scale(double s) { r *= s; }
+  void move(double dx, double dy) { x += dx; y += dy; }
+  int sides() { return K + 3; }
+  const char *name() { return "polygon"; }
+};
+
+#ifdef BINDING_SIZE_EXTERN
+ARCHETYPE_EXTERN_BINDING(shape, polygon<0>)
+ARCHETYPE_EXTERN_BINDING(shape, polygon<1>)
+ARCHETYPE_EXTERN_BINDING(shape, polygon<2>)
+ARCHETYPE_EXTERN_BINDING(shape, polygon<3>)
+ARCHETYPE_EXTERN_BINDING(shape, polygon<4>)
+ARCHETYPE_EXTERN_BINDING(shape, polygon<5>)
+ARCHETYPE_EXTERN_BINDING(shape, polygon<6>)
+ARCHETYPE_EXTERN_BINDING(shape, polygon<7>)
+#endif
+
+// Views of one of each polygon, moved and scaled through the views
+template <int Seed>
+double scene() {
+  polygon<0> p0; polygon<1> p1; polygon<2> p2; polygon<3> p3;
+  polygon<4> p4; polygon<5> p5; polygon<6> p6; polygon<7> p7;
+  shape::view views[] = {p0, p1, p2, p3, p4, p5, p6, p7};
+  double sum = 0;
+  for (auto &v : views) {
+    v.move(Seed, Seed);
+    v.scale(1.5);
+    sum += v.area() + v.perimeter() + v.sides() + v.name()[0];
+  }
+  return sum;
+}
+
+double scene_a();
+double scene_b();
+double scene_c();
+double scene_d();
+
+#endif //__BINDING_SIZE_SHAPES_H__
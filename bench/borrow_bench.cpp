@@ -0,0 +1,88 @@
+#include "archetype/archetype.h"
+#include "archetype/borrow.h"
+#include "bench.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Throughput of counting lines in a 64MB file, copying through fread into a
+// caller buffer, borrowing from a mapped_file, and borrowing from a
+// reader_buffer over the copying reader
+
+ARCHETYPE_DEFINE(readable, (ARCHETYPE_METHOD(int, read, char *, size_t)))
+
+struct file_reader {
+  std::FILE * file;
+  int read(char * buf, size_t n) {
+    return static_cast<int>(std::fread(buf, 1, n, file));
+  }
+};
+
+std::size_t count_lines(const char * p, std::size_t n) {
+  std::size_t lines = 0;
+  const char * end = p + n;
+  while ((p = static_cast<const char *>(std::memchr(p, '\n', end - p)))) {
+    lines++;
+    p++;
+  }
+  return lines;
+}
+
+std::size_t count_borrowed(archetype::borrowing_reader::view in) {
+  std::size_t lines = 0;
+  archetype::read_window w;
+  while ((w = in.peek(1)).size) {
+    lines += count_lines(w.data, w.size);
+    in.consume(w.size);
+  }
+  return lines;
+}
+
+int main() {
+  const std::size_t bytes = 64 << 20;
+  char path[] = "/tmp/archetype-borrow-bench-XXXXXX";
+  int fd = ::mkstemp(path);
+  if (fd < 0) { return 1; }
+  std::vector<char> line(80, 'x');
+  line.back() = '\n';
+  for (std::size_t written = 0; written < bytes; written += line.size()) {
+    if (::write(fd, line.data(), line.size()) < 0) { return 1; }
+  }
+  ::close(fd);
+
+  bench::header("counting lines in a 64MB file");
+
+  bench::report_rate("readable::view, fread into a buffer", bench::mb_per_s(bytes, [&] {
+    std::FILE * f = std::fopen(path, "rb");
+    file_reader reader{f};
+    readable::view in(reader);
+    std::vector<char> buf(64 << 10);
+    std::size_t lines = 0;
+    int n;
+    while ((n = in.read(buf.data(), buf.size())) > 0) {
+      lines += count_lines(buf.data(), static_cast<std::size_t>(n));
+    }
+    bench::do_not_optimize(lines);
+    std::fclose(f);
+  }));
+
+  bench::report_rate("archetype::mapped_file", bench::mb_per_s(bytes, [&] {
+    archetype::mapped_file file;
+    file.open(path);
+    std::size_t lines = count_borrowed(file);
+    bench::do_not_optimize(lines);
+  }));
+
+  bench::report_rate("archetype::reader_buffer over fread", bench::mb_per_s(bytes, [&] {
+    std::FILE * f = std::fopen(path, "rb");
+    file_reader reader{f};
+    archetype::reader_buffer<readable::view> in(reader);
+    std::size_t lines = count_borrowed(in);
+    bench::do_not_optimize(lines);
+    std::fclose(f);
+  }));
+
+  ::unlink(path);
+  return 0;
+}
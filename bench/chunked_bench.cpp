@@ -0,0 +1,80 @@
+#include "archetype/archetype.h"
+#include "archetype/chunked.h"
+#include "bench.h"
+#include <cstdio>
+#include <vector>
+
+// Elements per second read through a view: one call per element against
+// chunked_source views reading 1 to 256 elements per call, from a per
+// element source and from a std::vector
+
+ARCHETYPE_DEFINE(int_stream, (ARCHETYPE_METHOD(bool, next, int &)))
+
+struct count_up {
+  int i, n;
+  bool next(int & x) {
+    if (i == n) { return false; }
+    x = i++;
+    return true;
+  }
+};
+
+template <std::size_t N>
+void chunked_from_next(int n) {
+  char name[64];
+  std::snprintf(name, sizeof(name), "chunked_source of next(), %zu per call", N);
+  bench::report_per_s(name, bench::ns_per_op(n, [&](std::size_t) {
+    count_up c{0, n};
+    archetype::next_chunks<int, count_up &> chunks(c);
+    archetype::chunked_source<int>::view v(chunks);
+    bench::do_not_optimize(v);
+    int sum = 0;
+    archetype::for_each_chunked<int, N>(v, [&](int x) { sum += x; });
+    bench::do_not_optimize(sum);
+  }));
+}
+
+template <std::size_t N>
+void chunked_from_vector(const std::vector<int> & values) {
+  char name[64];
+  std::snprintf(name, sizeof(name), "chunked_source of vector, %zu per call", N);
+  bench::report_per_s(name, bench::ns_per_op(values.size(), [&](std::size_t) {
+    auto chunks = archetype::chunks_of(values);
+    archetype::chunked_source<int>::view v(chunks);
+    bench::do_not_optimize(v);
+    int sum = 0;
+    archetype::for_each_chunked<int, N>(v, [&](int x) { sum += x; });
+    bench::do_not_optimize(sum);
+  }));
+}
+
+int main() {
+  const int n = 20000000;
+
+  bench::header("elements read through a view");
+
+  bench::report_per_s("int_stream::view, 1 per call", bench::ns_per_op(n, [&](std::size_t) {
+    count_up c{0, n};
+    int_stream::view v(c);
+    bench::do_not_optimize(v);
+    int sum = 0, x;
+    while (v.next(x)) { sum += x; }
+    bench::do_not_optimize(sum);
+  }));
+
+  chunked_from_next<1>(n);
+  chunked_from_next<4>(n);
+  chunked_from_next<16>(n);
+  chunked_from_next<64>(n);
+  chunked_from_next<256>(n);
+
+  std::vector<int> values(n);
+  for (int i = 0; i < n; i++) { values[i] = i; }
+  chunked_from_vector<1>(values);
+  chunked_from_vector<4>(values);
+  chunked_from_vector<16>(values);
+  chunked_from_vector<64>(values);
+  chunked_from_vector<256>(values);
+
+  return 0;
+}
@@ -0,0 +1,90 @@
+#include "archetype/archetype.h"
+#include "archetype/compact.h"
+#include "bench.h"
+#include <vector>
+
+// Memory footprint and iteration speed of large collections of views,
+// erased views against compact views and a view_array
+
+ARCHETYPE_DEFINE(accumulator, (ARCHETYPE_METHOD(int, add, int)))
+
+template <int Shift> struct codec {
+  int state = 0;
+  int add(int x) { return state += (x << Shift); }
+};
+
+template <typename Collection>
+double time_iteration(Collection & views, std::size_t rounds) {
+  return bench::ns_per_op(rounds * views.size(), [&](std::size_t) {
+    for (std::size_t r = 0; r < rounds; r++) {
+      for (auto v : views) {
+        v.add(static_cast<int>(r));
+      }
+    }
+    bench::clobber();
+  });
+}
+
+template <typename View>
+double time_for_each(archetype::view_array<accumulator> & views,
+                     std::size_t rounds) {
+  return bench::ns_per_op(rounds * views.size(), [&](std::size_t) {
+    for (std::size_t r = 0; r < rounds; r++) {
+      views.for_each([r](View v) { v.add(static_cast<int>(r)); });
+    }
+    bench::clobber();
+  });
+}
+
+int main() {
+  const std::size_t count = 1000000;
+  const std::size_t rounds = 20;
+
+  // objects of 5 types in one buffer each, bound in shuffled order
+  std::vector<codec<0>> c0(count); std::vector<codec<1>> c1(count);
+  std::vector<codec<2>> c2(count); std::vector<codec<3>> c3(count);
+  std::vector<codec<4>> c4(count);
+
+  std::vector<accumulator::view> erased_views;
+  std::vector<archetype::compact_view<accumulator>> compact_views;
+  archetype::view_array<accumulator> array_views;
+  erased_views.reserve(count);
+  compact_views.reserve(count);
+  array_views.reserve(count);
+
+  unsigned seed = 12345;
+  for (std::size_t i = 0; i < count; i++) {
+    seed = seed * 1103515245u + 12345u;
+    accumulator::view v;
+    switch ((seed >> 16) % 5) {
+    case 0: v = accumulator::view(c0[i]); break;
+    case 1: v = accumulator::view(c1[i]); break;
+    case 2: v = accumulator::view(c2[i]); break;
+    case 3: v = accumulator::view(c3[i]); break;
+    default: v = accumulator::view(c4[i]); break;
+    }
+    erased_views.push_back(v);
+    compact_views.emplace_back(v);
+    array_views.push_back(v);
+  }
+
+  bench::header("bytes per element");
+  std::printf("%-48s %10zu\n", "accumulator::view", sizeof(accumulator::view));
+  std::printf("%-48s %10zu\n", "archetype::compact_view",
+              sizeof(archetype::compact_view<accumulator>));
+  std::printf("%-48s %10zu\n", "archetype::view_array",
+              sizeof(void *) + sizeof(unsigned short));
+
+  bench::header("iteration over 1M views of 5 shuffled types");
+  bench::report("std::vector<accumulator::view>",
+                time_iteration(erased_views, rounds));
+  bench::report("std::vector<archetype::compact_view>",
+                time_iteration(compact_views, rounds));
+  bench::report("archetype::view_array",
+                time_iteration(array_views, rounds));
+  bench::report("archetype::view_array::for_each",
+                time_for_each<archetype::compact_view<accumulator>>(
+                    array_views, rounds));
+
+  return 0;
+}
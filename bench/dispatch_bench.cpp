@@ -0,0 +1,147 @@
+#include "archetype/archetype.h"
+#include "bench.h"
+#include <vector>
+
+// Cost of a call through each kind of view, against a direct call and a
+// virtual call
+
+ARCHETYPE_DEFINE(accumulator, (ARCHETYPE_METHOD(int, add, int)))
+
+struct counter {
+  int total = 0;
+  int add(int x) { return total += x; }
+};
+
+struct abstract_counter {
+  virtual ~abstract_counter() {}
+  virtual int add(int x) = 0;
+};
+
+struct derived_counter : public abstract_counter {
+  int total = 0;
+  int add(int x) override { return total += x; }
+};
+
+// A closed set of implementations, for the polymorphic array
+template <int Shift> struct codec {
+  int state = 0;
+  int add(int x) { return state += (x << Shift); }
+};
+
+using codec_variant = archetype::variant_view<accumulator, codec<0>, codec<1>,
+                                              codec<2>, codec<3>, codec<4>>;
+
+// Types with a size member at different offsets, read through a getter
+// method or an ARCHETYPE_FIELD
+ARCHETYPE_DEFINE(size_getter, (ARCHETYPE_METHOD(int, get_size)))
+ARCHETYPE_DEFINE(size_field, (ARCHETYPE_FIELD(int, size)))
+
+template <int Pad> struct item {
+  char pad[Pad * 8];
+  int size = Pad;
+  int get_size() { return size; }
+};
+
+template <typename View, typename Read>
+double time_reads(std::vector<View> & views, std::size_t rounds, Read read) {
+  return bench::ns_per_op(rounds * views.size(), [&](std::size_t) {
+    int sum = 0;
+    for (std::size_t r = 0; r < rounds; r++) {
+      for (auto & v : views) {
+        sum += read(v);
+      }
+    }
+    bench::do_not_optimize(sum);
+  });
+}
+
+template <typename View>
+double time_calls(View & v, std::size_t n) {
+  return bench::ns_per_op(n, [&](std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) {
+      v.add(static_cast<int>(i));
+    }
+    bench::clobber();
+  });
+}
+
+template <typename View>
+double time_array(std::vector<View> & views, std::size_t rounds) {
+  return bench::ns_per_op(rounds * views.size(), [&](std::size_t) {
+    for (std::size_t r = 0; r < rounds; r++) {
+      for (auto & v : views) {
+        v.add(static_cast<int>(r));
+      }
+    }
+    bench::clobber();
+  });
+}
+
+int main() {
+  const std::size_t n = 100000000;
+
+  bench::header("single call site, monomorphic");
+
+  counter c;
+  counter * direct = &c;
+  bench::do_not_optimize(direct);
+  bench::report("direct call", time_calls(*direct, n));
+
+  derived_counter d;
+  abstract_counter * base = &d;
+  bench::do_not_optimize(base);
+  bench::report("virtual call", time_calls(*base, n));
+
+  accumulator::view erased(c);
+  bench::do_not_optimize(erased);
+  bench::report("accumulator::view", time_calls(erased, n));
+
+  archetype::static_view<accumulator, counter> monomorphic(c);
+  bench::do_not_optimize(monomorphic);
+  bench::report("archetype::static_view", time_calls(monomorphic, n));
+
+  bench::header("array of 5 shuffled types");
+
+  const std::size_t count = 10000;
+  const std::size_t rounds = 2000;
+  codec<0> c0; codec<1> c1; codec<2> c2; codec<3> c3; codec<4> c4;
+  std::vector<accumulator::view> erased_views;
+  std::vector<codec_variant> variant_views;
+  unsigned seed = 12345;
+  for (std::size_t i = 0; i < count; i++) {
+    seed = seed * 1103515245u + 12345u;
+    switch ((seed >> 16) % 5) {
+    case 0: erased_views.emplace_back(c0); variant_views.emplace_back(c0); break;
+    case 1: erased_views.emplace_back(c1); variant_views.emplace_back(c1); break;
+    case 2: erased_views.emplace_back(c2); variant_views.emplace_back(c2); break;
+    case 3: erased_views.emplace_back(c3); variant_views.emplace_back(c3); break;
+    default: erased_views.emplace_back(c4); variant_views.emplace_back(c4); break;
+    }
+  }
+
+  bench::report("accumulator::view", time_array(erased_views, rounds));
+  bench::report("archetype::variant_view", time_array(variant_views, rounds));
+
+  bench::header("reading a member of 5 shuffled types");
+
+  item<1> i1; item<2> i2; item<3> i3; item<4> i4; item<5> i5;
+  std::vector<size_getter::view> getters;
+  std::vector<size_field::view> fields;
+  for (std::size_t i = 0; i < count; i++) {
+    seed = seed * 1103515245u + 12345u;
+    switch ((seed >> 16) % 5) {
+    case 0: getters.emplace_back(i1); fields.emplace_back(i1); break;
+    case 1: getters.emplace_back(i2); fields.emplace_back(i2); break;
+    case 2: getters.emplace_back(i3); fields.emplace_back(i3); break;
+    case 3: getters.emplace_back(i4); fields.emplace_back(i4); break;
+    default: getters.emplace_back(i5); fields.emplace_back(i5); break;
+    }
+  }
+
+  bench::report("ARCHETYPE_METHOD getter",
+                time_reads(getters, rounds, [](size_getter::view & v) { return v.get_size(); }));
+  bench::report("ARCHETYPE_FIELD",
+                time_reads(fields, rounds, [](size_field::view & v) { return v.size(); }));
+
+  return 0;
+}
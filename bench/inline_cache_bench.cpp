@@ -0,0 +1,62 @@
+#include "archetype/archetype.h"
+#include "archetype/inline_cache.h"
+#include "bench.h"
+#include <cstdio>
+#include <vector>
+
+// Erased calls through a plain view against an inline cache registering
+// four of eight types, at call sites seeing 1, 2, 4 and 8 types in a
+// random order. Sites seeing only registered types always hit.
+
+ARCHETYPE_DEFINE(transform, (ARCHETYPE_METHOD(int, apply, int)))
+
+template <int K>
+struct scale {
+  int offset = K;
+  int apply(int x) { return x * K + offset; }
+};
+
+using site_type =
+    archetype::inline_cache<transform, scale<1>, scale<2>, scale<3>, scale<4>>;
+
+int main() {
+  const std::size_t n = 4096;
+  const int passes = 10000;
+  scale<1> s1; scale<2> s2; scale<3> s3; scale<4> s4;
+  scale<5> s5; scale<6> s6; scale<7> s7; scale<8> s8;
+  transform::view all[] = {s1, s2, s3, s4, s5, s6, s7, s8};
+
+  bench::header("calls per site by number of types seen");
+
+  for (unsigned types : {1u, 2u, 4u, 8u}) {
+    std::vector<transform::view> views(n);
+    unsigned long long seed = 88172645463325252ull;
+    for (auto & v : views) {
+      seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+      v = all[(seed >> 32) % types];
+    }
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "transform::view, %u types", types);
+    bench::report(name, bench::ns_per_op(n * passes, [&](std::size_t) {
+      int sum = 0;
+      for (int p = 0; p < passes; p++) {
+        for (auto & v : views) { sum += v.apply(p); }
+      }
+      bench::do_not_optimize(sum);
+    }));
+
+    site_type site;
+    std::snprintf(name, sizeof(name), "inline_cache of 4 types, %u types", types);
+    bench::report(name, bench::ns_per_op(n * passes, [&](std::size_t) {
+      int sum = 0;
+      for (int p = 0; p < passes; p++) {
+        for (auto & v : views) { sum += site(v).apply(p); }
+      }
+      bench::do_not_optimize(sum);
+    }));
+    std::printf("%-48s %10.1f %%\n", "  hit rate", site.hit_rate() * 100);
+  }
+
+  return 0;
+}
@@ -0,0 +1,94 @@
+#include "archetype/archetype.h"
+#include "archetype/ipc.h"
+#include "bench.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <signal.h>
+#include <sys/wait.h>
+
+// Round trip latency of calls to another process through an ipc_client,
+// for small values, strings, and 64KB buffers copied into the request or
+// passed zero copy from the scratch area
+
+ARCHETYPE_DEFINE(service, (ARCHETYPE_METHOD(int, add, int),
+                           ARCHETYPE_METHOD(std::size_t, length, const char *),
+                           ARCHETYPE_METHOD(unsigned, first, archetype::ipc_span)))
+
+struct local_service {
+  int total = 0;
+  int add(int x) { return total += x; }
+  std::size_t length(const char * s) { return std::strlen(s); }
+  unsigned first(archetype::ipc_span b) {
+    return b.size ? *static_cast<const unsigned char *>(b.data) : 0;
+  }
+};
+
+int main() {
+  std::string name = "/archetype-bench-" + std::to_string(::getpid());
+  archetype::ipc_channel channel;
+  if (!channel.create(name.c_str(), 1 << 18, 1 << 20)) {
+    std::printf("could not create %s\n", name.c_str());
+    return 1;
+  }
+
+  pid_t child = ::fork();
+  if (child == 0) {
+    archetype::ipc_channel served;
+    if (!served.open(name.c_str())) { ::_exit(1); }
+    local_service s;
+    archetype::ipc_server<service> server(served, service::view(s));
+    for (;;) { server.serve_one(); }
+  }
+
+  archetype::ipc_client<service> client(channel);
+  local_service local;
+  service::view direct(local);
+  const std::size_t calls = 100000;
+
+  bench::header("int add(int)");
+  bench::report("service::view, same process", bench::ns_per_op(calls, [&](std::size_t n) {
+    int r = 0;
+    for (std::size_t i = 0; i < n; i++) { r = direct.add(1); }
+    bench::do_not_optimize(r);
+  }));
+  bench::report("archetype::ipc_client", bench::ns_per_op(calls, [&](std::size_t n) {
+    int r = 0;
+    for (std::size_t i = 0; i < n; i++) { r = client.add(1); }
+    bench::do_not_optimize(r);
+  }));
+
+  bench::header("size_t length(const char *), 32 characters");
+  const char * text = "0123456789abcdef0123456789abcdef";
+  bench::report("archetype::ipc_client", bench::ns_per_op(calls, [&](std::size_t n) {
+    std::size_t r = 0;
+    for (std::size_t i = 0; i < n; i++) { r = client.length(text); }
+    bench::do_not_optimize(r);
+  }));
+
+  bench::header("unsigned first(ipc_span), 64KB");
+  const std::size_t bytes = 64 * 1024;
+  std::vector<unsigned char> heap(bytes, 1);
+  unsigned char * scratch = static_cast<unsigned char *>(channel.scratch(bytes));
+  std::memset(scratch, 1, bytes);
+  bench::report("archetype::ipc_client, copied", bench::ns_per_op(calls / 10, [&](std::size_t n) {
+    unsigned r = 0;
+    for (std::size_t i = 0; i < n; i++) {
+      r = client.first(archetype::ipc_span{heap.data(), bytes});
+    }
+    bench::do_not_optimize(r);
+  }));
+  bench::report("archetype::ipc_client, zero copy", bench::ns_per_op(calls / 10, [&](std::size_t n) {
+    unsigned r = 0;
+    for (std::size_t i = 0; i < n; i++) {
+      r = client.first(archetype::ipc_span{scratch, bytes});
+    }
+    bench::do_not_optimize(r);
+  }));
+
+  ::kill(child, SIGTERM);
+  ::waitpid(child, nullptr, 0);
+  return 0;
+}
@@ -0,0 +1,63 @@
+#include "archetype/archetype.h"
+#include "archetype/memo_cache.h"
+#include "bench.h"
+#include <cstdio>
+#include <vector>
+
+// A pure cost estimate costing about a hundred multiply adds, called
+// through a plain view and through a memo_cache, with queries drawn from
+// 16, 256 and 4096 distinct values against a cache of 1024 entries
+
+ARCHETYPE_DEFINE(estimator, (ARCHETYPE_PURE_METHOD(double, cost, int)))
+
+template <int K>
+struct polynomial {
+  double cost(int q) {
+    double x = q * 1e-3, sum = 0;
+    for (int i = 0; i < 100; i++) { sum = sum * x + (i % 7) + K; }
+    return sum;
+  }
+};
+
+int main() {
+  const std::size_t n = 4096;
+  const int passes = 200;
+  polynomial<1> p1; polynomial<2> p2; polynomial<3> p3; polynomial<4> p4;
+  estimator::view all[] = {p1, p2, p3, p4};
+
+  bench::header("pure calls by number of distinct queries");
+
+  for (unsigned distinct : {16u, 256u, 4096u}) {
+    std::vector<estimator::view> views(n);
+    std::vector<int> queries(n);
+    unsigned long long seed = 88172645463325252ull;
+    for (std::size_t i = 0; i < n; i++) {
+      seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+      views[i] = all[(seed >> 32) % 4];
+      queries[i] = static_cast<int>((seed >> 8) % (distinct / 4));
+    }
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "estimator::view, %u distinct", distinct);
+    bench::report(name, bench::ns_per_op(n * passes, [&](std::size_t) {
+      double sum = 0;
+      for (int p = 0; p < passes; p++) {
+        for (std::size_t i = 0; i < n; i++) { sum += views[i].cost(queries[i]); }
+      }
+      bench::do_not_optimize(sum);
+    }));
+
+    archetype::memo_cache<estimator> cache(1024);
+    std::snprintf(name, sizeof(name), "memo_cache of 1024, %u distinct", distinct);
+    bench::report(name, bench::ns_per_op(n * passes, [&](std::size_t) {
+      double sum = 0;
+      for (int p = 0; p < passes; p++) {
+        for (std::size_t i = 0; i < n; i++) { sum += cache(views[i]).cost(queries[i]); }
+      }
+      bench::do_not_optimize(sum);
+    }));
+    std::printf("%-48s %10.1f %%\n", "  hit rate", cache.hit_rate() * 100);
+  }
+
+  return 0;
+}
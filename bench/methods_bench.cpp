@@ -0,0 +1,75 @@
+#include "archetype/archetype.h"
+#include "archetype/methods.h"
+#include "bench.h"
+#include <map>
+#include <string>
+#include <unordered_map>
+
+// Cost of calling a method by name, the perfect hash method_table against
+// std::map and std::unordered_map keyed by name
+
+ARCHETYPE_DEFINE(transform, (ARCHETYPE_METHOD(void, translate, int),
+                             ARCHETYPE_METHOD(void, rotate, int),
+                             ARCHETYPE_METHOD(void, scale, int),
+                             ARCHETYPE_METHOD(void, skew, int)))
+ARCHETYPE_DEFINE(style, (ARCHETYPE_METHOD(void, set_color, int),
+                         ARCHETYPE_METHOD(void, set_width, int),
+                         ARCHETYPE_METHOD(void, set_opacity, int),
+                         ARCHETYPE_METHOD(void, set_layer, int)))
+ARCHETYPE_COMPOSE(shape, transform, style)
+
+struct node {
+  int state = 0;
+  void translate(int x) { state += x; }
+  void rotate(int x) { state ^= x; }
+  void scale(int x) { state *= x | 1; }
+  void skew(int x) { state -= x; }
+  void set_color(int x) { state += 2 * x; }
+  void set_width(int x) { state ^= 2 * x; }
+  void set_opacity(int x) { state -= 2 * x; }
+  void set_layer(int x) { state += 3 * x; }
+};
+
+using table = archetype::method_table<shape>;
+
+int main() {
+  const std::size_t n = 10000000;
+  const char * names[table::size];
+  std::map<std::string, table::thunk> ordered;
+  std::unordered_map<std::string, table::thunk> hashed;
+  for (std::size_t i = 0; i < table::size; i++) {
+    names[i] = table::name(i);
+    ordered[names[i]] = table::lookup(names[i])->call;
+    hashed[names[i]] = table::lookup(names[i])->call;
+  }
+
+  node target;
+  shape::view v(target);
+  int arg = 3;
+  void * args[] = {&arg};
+
+  bench::header("call by name, 8 methods");
+  bench::report("archetype::method_table::invoke",
+                bench::ns_per_op(n, [&](std::size_t count) {
+                  for (std::size_t i = 0; i < count; i++) {
+                    table::invoke(v, names[i % table::size], args, nullptr);
+                  }
+                  bench::clobber();
+                }));
+  bench::report("std::unordered_map<std::string>",
+                bench::ns_per_op(n, [&](std::size_t count) {
+                  for (std::size_t i = 0; i < count; i++) {
+                    hashed.find(names[i % table::size])->second(v, args, nullptr);
+                  }
+                  bench::clobber();
+                }));
+  bench::report("std::map<std::string>",
+                bench::ns_per_op(n, [&](std::size_t count) {
+                  for (std::size_t i = 0; i < count; i++) {
+                    ordered.find(names[i % table::size])->second(v, args, nullptr);
+                  }
+                  bench::clobber();
+                }));
+
+  return 0;
+}
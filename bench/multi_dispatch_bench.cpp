@@ -0,0 +1,137 @@
+#include "archetype/archetype.h"
+#include "archetype/multi_dispatch.h"
+#include "bench.h"
+#include <cstdio>
+#include <tuple>
+#include <vector>
+
+// Behaviour picked by two erased types: double dispatch through two view
+// calls against one multi_dispatch table lookup, over random pairs of 4
+// types, and the table alone over 32 types
+
+template <std::size_t K> struct shape;
+
+ARCHETYPE_DEFINE(collider, (ARCHETYPE_METHOD(int, with, shape<0> &),
+                            ARCHETYPE_METHOD(int, with, shape<1> &),
+                            ARCHETYPE_METHOD(int, with, shape<2> &),
+                            ARCHETYPE_METHOD(int, with, shape<3> &)))
+
+ARCHETYPE_DEFINE(body, (ARCHETYPE_METHOD(int, collide, collider::view &)))
+
+ARCHETYPE_DEFINE(weighted, (ARCHETYPE_FIELD(int, weight)))
+
+template <std::size_t K>
+struct shape {
+  int weight = static_cast<int>(K) + 1;
+  int collide(collider::view & other) { return other.with(*this); }
+  template <std::size_t J> int with(shape<J> & o) { return weight * 64 + o.weight; }
+};
+
+template <std::size_t K>
+struct particle {
+  int weight = static_cast<int>(K) + 1;
+};
+
+template <template <std::size_t> class T, std::size_t I, std::size_t J>
+int hit(T<I> & a, T<J> & b) { return a.weight * 64 + b.weight; }
+
+using table_type = archetype::multi_dispatch<weighted, weighted, int()>;
+
+// Registers hit for every pair of T<0> to T<N - 1>
+template <template <std::size_t> class T, std::size_t I, std::size_t... Js>
+void add_row(table_type & t, archetype::indices<Js...>) {
+  int added[] = {(t.add<T<I>, T<Js>, &hit<T, I, Js>>(), 0)...};
+  (void)added;
+}
+
+template <template <std::size_t> class T, std::size_t... Is>
+void add_all(table_type & t, archetype::indices<Is...> all) {
+  int added[] = {(add_row<T, Is>(t, all), 0)...};
+  (void)added;
+}
+
+template <typename Indices> struct particle_tuple;
+
+template <std::size_t... Is>
+struct particle_tuple<archetype::indices<Is...>> {
+  using type = std::tuple<particle<Is>...>;
+};
+
+template <std::size_t... Is>
+std::vector<weighted::view> particle_views(std::tuple<particle<Is>...> & ps,
+                                           archetype::indices<Is...>) {
+  return {weighted::view(std::get<Is>(ps))...};
+}
+
+std::vector<std::size_t> random_picks(std::size_t n, std::size_t types,
+                                      unsigned long long seed) {
+  std::vector<std::size_t> picks(n);
+  for (auto & p : picks) {
+    seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+    p = (seed >> 32) % types;
+  }
+  return picks;
+}
+
+int main() {
+  const std::size_t n = 4096;
+  const int passes = 5000;
+
+  bench::header("dispatch on two erased types");
+
+  shape<0> s0; shape<1> s1; shape<2> s2; shape<3> s3;
+  std::vector<std::size_t> left = random_picks(n, 4, 88172645463325252ull);
+  std::vector<std::size_t> right = random_picks(n, 4, 1181783497276652981ull);
+
+  body::view bodies[] = {s0, s1, s2, s3};
+  collider::view colliders[] = {s0, s1, s2, s3};
+  std::vector<body::view> a(n);
+  std::vector<collider::view> b(n);
+  for (std::size_t i = 0; i < n; i++) {
+    a[i] = bodies[left[i]];
+    b[i] = colliders[right[i]];
+  }
+  bench::report("double dispatch, 4 types", bench::ns_per_op(n * passes, [&](std::size_t) {
+    int sum = 0;
+    for (int p = 0; p < passes; p++) {
+      for (std::size_t i = 0; i < n; i++) { sum += a[i].collide(b[i]); }
+    }
+    bench::do_not_optimize(sum);
+  }));
+
+  table_type shapes;
+  add_all<shape>(shapes, archetype::make_indices<4>::type());
+  weighted::view weights[] = {s0, s1, s2, s3};
+  std::vector<weighted::view> wa(n), wb(n);
+  for (std::size_t i = 0; i < n; i++) {
+    wa[i] = weights[left[i]];
+    wb[i] = weights[right[i]];
+  }
+  bench::report("multi_dispatch, 4 types", bench::ns_per_op(n * passes, [&](std::size_t) {
+    int sum = 0;
+    for (int p = 0; p < passes; p++) {
+      for (std::size_t i = 0; i < n; i++) { sum += shapes(wa[i], wb[i]); }
+    }
+    bench::do_not_optimize(sum);
+  }));
+
+  table_type particles;
+  add_all<particle>(particles, archetype::make_indices<32>::type());
+  static particle_tuple<archetype::make_indices<32>::type>::type ps;
+  std::vector<weighted::view> all = particle_views(ps, archetype::make_indices<32>::type());
+  left = random_picks(n, 32, 88172645463325252ull);
+  right = random_picks(n, 32, 1181783497276652981ull);
+  for (std::size_t i = 0; i < n; i++) {
+    wa[i] = all[left[i]];
+    wb[i] = all[right[i]];
+  }
+  bench::report("multi_dispatch, 32 types", bench::ns_per_op(n * passes, [&](std::size_t) {
+    int sum = 0;
+    for (int p = 0; p < passes; p++) {
+      for (std::size_t i = 0; i < n; i++) { sum += particles(wa[i], wb[i]); }
+    }
+    bench::do_not_optimize(sum);
+  }));
+
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include "archetype/archetype.h"
+#include "archetype/multicast.h"
+#include "bench.h"
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+// Publish latency to N subscribers of 4 types, a multicast against looping
+// over a std::vector of views under a mutex
+
+ARCHETYPE_DEFINE(listener, (ARCHETYPE_METHOD(void, on_event, int)))
+
+template <int Kind> struct handler {
+  int seen = 0;
+  void on_event(int e) { seen += e + Kind; }
+};
+
+struct locked_listeners {
+  std::mutex m;
+  std::vector<listener::view> views;
+
+  void on_event(int e) {
+    std::lock_guard<std::mutex> lock(m);
+    for (auto & v : views) { v.on_event(e); }
+  }
+};
+
+int main() {
+  for (std::size_t subscribers = 1; subscribers <= 1024; subscribers *= 8) {
+    std::vector<handler<0>> h0(subscribers); std::vector<handler<1>> h1(subscribers);
+    std::vector<handler<2>> h2(subscribers); std::vector<handler<3>> h3(subscribers);
+
+    locked_listeners locked;
+    archetype::multicast<listener> multicast;
+    for (std::size_t i = 0; i < subscribers; i++) {
+      // interleaved subscription order, multicast regroups by type
+      listener::view v;
+      switch (i % 4) {
+      case 0: v = listener::view(h0[i]); break;
+      case 1: v = listener::view(h1[i]); break;
+      case 2: v = listener::view(h2[i]); break;
+      default: v = listener::view(h3[i]); break;
+      }
+      locked.views.push_back(v);
+      multicast.subscribe(v);
+    }
+
+    const std::size_t publishes = 10000000 / subscribers;
+    char title[64];
+    std::snprintf(title, sizeof(title), "%zu subscribers, ns per publish",
+                  subscribers);
+    bench::header(title);
+    bench::report("mutex + std::vector<listener::view>",
+                  bench::ns_per_op(publishes, [&](std::size_t n) {
+                    for (std::size_t i = 0; i < n; i++) {
+                      locked.on_event(static_cast<int>(i));
+                    }
+                    bench::clobber();
+                  }));
+    bench::report("archetype::multicast",
+                  bench::ns_per_op(publishes, [&](std::size_t n) {
+                    for (std::size_t i = 0; i < n; i++) {
+                      multicast.on_event(static_cast<int>(i));
+                    }
+                    bench::clobber();
+                  }));
+  }
+
+  return 0;
+}
@@ -0,0 +1,84 @@
+#include "archetype/archetype.h"
+#include "archetype/compact.h"
+#include "archetype/parallel.h"
+#include "bench.h"
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// Scaling of parallel_for_each over 1M views of 4 shuffled types, from one
+// thread up to the number of hardware threads
+
+ARCHETYPE_DEFINE(updatable, (ARCHETYPE_METHOD(void, update, float)))
+
+template <int Kind> struct particle {
+  float x = 0, v = 1;
+  void update(float dt) {
+    for (int i = 0; i <= Kind; i++) {
+      v = v * 0.99f + dt;
+      x += v * dt;
+    }
+  }
+};
+
+int main() {
+  const std::size_t count = 1000000;
+
+  std::vector<particle<0>> p0(count); std::vector<particle<1>> p1(count);
+  std::vector<particle<2>> p2(count); std::vector<particle<3>> p3(count);
+
+  std::vector<updatable::view> views;
+  archetype::view_array<updatable> array;
+  views.reserve(count);
+  array.reserve(count);
+  unsigned seed = 12345;
+  for (std::size_t i = 0; i < count; i++) {
+    seed = seed * 1103515245u + 12345u;
+    updatable::view v;
+    switch ((seed >> 16) % 4) {
+    case 0: v = updatable::view(p0[i]); break;
+    case 1: v = updatable::view(p1[i]); break;
+    case 2: v = updatable::view(p2[i]); break;
+    default: v = updatable::view(p3[i]); break;
+    }
+    views.push_back(v);
+    array.push_back(v);
+  }
+
+  bench::header("serial");
+  double serial = bench::ns_per_op(count, [&](std::size_t) {
+    for (auto & v : views) { v.update(0.01f); }
+    bench::clobber();
+  });
+  bench::report("for loop over std::vector<updatable::view>", serial);
+
+  unsigned hardware = std::thread::hardware_concurrency();
+  if (hardware == 0) { hardware = 1; }
+
+  std::vector<unsigned> thread_counts;
+  for (unsigned t = 1; t < hardware; t *= 2) { thread_counts.push_back(t); }
+  thread_counts.push_back(hardware);
+
+  for (unsigned threads : thread_counts) {
+    archetype::work_stealing_pool pool(threads);
+    char title[64];
+    std::snprintf(title, sizeof(title), "%u thread(s)", threads);
+    bench::header(title);
+
+    double vec = bench::ns_per_op(count, [&](std::size_t) {
+      archetype::parallel_for_each(pool, views.begin(), views.end(),
+                                   [](updatable::view & v) { v.update(0.01f); });
+    });
+    bench::report("std::vector<updatable::view>", vec);
+
+    double arr = bench::ns_per_op(count, [&](std::size_t) {
+      archetype::parallel_for_each(
+          pool, array,
+          [](archetype::compact_view<updatable> v) { v.update(0.01f); });
+    });
+    bench::report("archetype::view_array", arr);
+    std::printf("%-48s %10.2fx\n", "speedup over serial", serial / vec);
+  }
+
+  return 0;
+}
@@ -0,0 +1,105 @@
+#include "archetype/archetype.h"
+#include "archetype/pipeline.h"
+#include "bench.h"
+#include <cstring>
+#include <vector>
+
+// Throughput of a 4 stage in memory stream. Copying stages are readable
+// views reading from the stage before them into their own buffer, as the
+// mixins in src/mixin_patterns.cpp do. Pipeline stages pass buffer slices
+// by reference, inline or on a thread each.
+
+ARCHETYPE_DEFINE(readable, (ARCHETYPE_METHOD(int, read, char *, size_t)))
+
+struct memory_reader {
+  const char * data;
+  std::size_t size;
+  std::size_t offset;
+
+  int read(char * buf, size_t n) {
+    if (n > size - offset) { n = size - offset; }
+    std::memcpy(buf, data + offset, n);
+    offset += n;
+    return static_cast<int>(n);
+  }
+};
+
+struct copying_stage {
+  readable::view upstream;
+  std::vector<char> buffer;
+
+  int read(char * buf, size_t n) {
+    if (buffer.size() < n) { buffer.resize(n); }
+    int got = upstream.read(buffer.data(), n);
+    std::memcpy(buf, buffer.data(), static_cast<std::size_t>(got));
+    return got;
+  }
+};
+
+struct forward_stage {
+  bool process(const archetype::buffer_slice & in, archetype::slice_sink::view & out) {
+    return out.push(in);
+  }
+};
+
+// The same work at the end of both streams, summing every 64th byte
+struct checksum {
+  unsigned sum = 0;
+
+  void add(const char * p, std::size_t n) {
+    for (std::size_t i = 0; i < n; i += 64) { sum += static_cast<unsigned char>(p[i]); }
+  }
+
+  bool push(const archetype::buffer_slice & s) {
+    add(s.data(), s.size());
+    return true;
+  }
+};
+
+int main() {
+  const std::size_t bytes = 64 << 20;
+  const std::size_t stages = 4;
+  archetype::buffer_slice input = archetype::buffer_slice::allocate(bytes);
+  std::memset(input.mutable_data(), 7, bytes);
+
+  for (std::size_t chunk = 4 << 10; chunk <= (256 << 10); chunk *= 8) {
+    char title[64];
+    std::snprintf(title, sizeof(title), "%zu stages, %zuKB chunks", stages, chunk >> 10);
+    bench::header(title);
+
+    bench::report_rate("copying readable stages", bench::mb_per_s(bytes, [&] {
+      memory_reader source{input.data(), bytes, 0};
+      std::vector<copying_stage> chain(stages);
+      readable::view upstream(source);
+      for (auto & s : chain) {
+        s.upstream = upstream;
+        upstream = readable::view(s);
+      }
+      std::vector<char> buf(chunk);
+      checksum c;
+      int n;
+      while ((n = upstream.read(buf.data(), chunk)) > 0) {
+        c.add(buf.data(), static_cast<std::size_t>(n));
+      }
+      bench::do_not_optimize(c.sum);
+    }));
+
+    for (int threaded = 0; threaded < 2; threaded++) {
+      bench::report_rate(threaded ? "archetype::pipeline, a thread per stage"
+                                  : "archetype::pipeline, inline stages",
+                         bench::mb_per_s(bytes, [&] {
+        archetype::slice_chunks source(input, chunk);
+        forward_stage forward;
+        archetype::pipeline p(16);
+        for (std::size_t s = 0; s < stages; s++) {
+          if (threaded) { p.then_threaded(forward); } else { p.then(forward); }
+        }
+        checksum c;
+        p.run(source, c);
+        bench::do_not_optimize(c.sum);
+      }));
+    }
+  }
+
+  return 0;
+}
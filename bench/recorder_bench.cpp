@@ -0,0 +1,66 @@
+#include "archetype/archetype.h"
+#include "archetype/recorder.h"
+#include "bench.h"
+#include <cstdio>
+
+// Cost of recording calls into a call_buffer and replaying them, against
+// calling through a view directly
+
+ARCHETYPE_DEFINE(canvas, (ARCHETYPE_METHOD(void, move_to, float, float),
+                          ARCHETYPE_METHOD(void, line_to, float, float),
+                          ARCHETYPE_METHOD(void, set_width, int)))
+
+struct path_length {
+  float x = 0, y = 0, length = 0;
+  int width = 0;
+  void move_to(float px, float py) { x = px; y = py; }
+  void line_to(float px, float py) {
+    length += (px - x) + (py - y);
+    x = px; y = py;
+  }
+  void set_width(int w) { width = w; }
+};
+
+template <typename View>
+void draw(View & v, std::size_t n) {
+  for (std::size_t i = 0; i < n; i++) {
+    float f = static_cast<float>(i);
+    v.move_to(f, f);
+    v.line_to(f + 1, f + 2);
+    v.set_width(static_cast<int>(i));
+  }
+}
+
+int main() {
+  const std::size_t n = 1000000;
+  path_length target;
+  canvas::view direct(target);
+  bench::do_not_optimize(direct);
+
+  archetype::call_buffer buffer;
+  archetype::recorder<canvas> rec(buffer);
+  draw(rec, n);
+  std::size_t bytes = buffer.size();
+
+  bench::header("3M calls");
+  bench::report("canvas::view calls",
+                bench::ns_per_op(3 * n, [&](std::size_t) {
+                  draw(direct, n);
+                  bench::clobber();
+                }));
+  bench::report("archetype::recorder, reused buffer",
+                bench::ns_per_op(3 * n, [&](std::size_t) {
+                  buffer.clear();
+                  draw(rec, n);
+                  bench::clobber();
+                }));
+  bench::report("archetype::replay",
+                bench::ns_per_op(3 * n, [&](std::size_t) {
+                  archetype::replay(buffer, direct);
+                  bench::clobber();
+                }));
+  std::printf("%-48s %10.2f\n", "bytes per recorded call",
+              static_cast<double>(bytes) / static_cast<double>(3 * n));
+
+  return 0;
+}
@@ -0,0 +1,153 @@
+#include "archetype/scheduler.h"
+#include "bench.h"
+#include <atomic>
+#include <cstdio>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Task throughput and hop latency on all local cores: task_scheduler
+// against a pool of threads sharing a queue of std::function<void()>.
+// Tasks carry 32 bytes, more than std::function stores inline.
+
+class function_pool {
+  public:
+  explicit function_pool(unsigned threads) : _pending(0), _stop(false) {
+    for (unsigned i = 0; i < threads; i++) {
+      _threads.emplace_back([this] {
+        std::function<void()> f;
+        while (_pop(f, true)) { _run(f); }
+      });
+    }
+  }
+
+  ~function_pool() {
+    wait();
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = true;
+    }
+    _wake.notify_all();
+    for (auto & t : _threads) { t.join(); }
+  }
+
+  void submit(std::function<void()> f) {
+    _pending.fetch_add(1, std::memory_order_relaxed);
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _queue.push_back(std::move(f));
+    }
+    _wake.notify_one();
+  }
+
+  void wait() {
+    std::function<void()> f;
+    while (_pending.load(std::memory_order_acquire) != 0) {
+      if (_pop(f, false)) {
+        _run(f);
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  private:
+  bool _pop(std::function<void()> & f, bool block) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (block) { _wake.wait(lock, [this] { return _stop || !_queue.empty(); }); }
+    if (_queue.empty()) { return false; }
+    f = std::move(_queue.front());
+    _queue.pop_front();
+    return true;
+  }
+
+  void _run(std::function<void()> & f) {
+    f();
+    f = nullptr;
+    _pending.fetch_sub(1, std::memory_order_acq_rel);
+  }
+
+  std::vector<std::thread> _threads;
+  std::mutex _mutex;
+  std::condition_variable _wake;
+  std::deque<std::function<void()>> _queue;
+  std::atomic<std::size_t> _pending;
+  bool _stop;
+};
+
+struct payload {
+  std::atomic<long> * total;
+  long a, b, c;
+};
+
+struct add_task {
+  payload p;
+  void run() { p.total->fetch_add(p.a + p.b + p.c, std::memory_order_relaxed); }
+};
+
+// Resubmits itself until hops run out, so each hop waits on the last
+struct hop_task {
+  archetype::task_scheduler * scheduler;
+  std::atomic<long> * total;
+  long hops, pad;
+  void run() {
+    total->fetch_add(1, std::memory_order_relaxed);
+    if (hops > 1) { scheduler->submit(hop_task{scheduler, total, hops - 1, pad}); }
+  }
+};
+
+void function_hop(function_pool * pool, std::atomic<long> * total, long hops, long pad) {
+  total->fetch_add(1, std::memory_order_relaxed);
+  if (hops > 1) {
+    pool->submit([=] { function_hop(pool, total, hops - 1, pad); });
+  }
+}
+
+int main() {
+  const unsigned threads = std::thread::hardware_concurrency();
+  const std::size_t tasks = 200000;
+  const long hops = 100000;
+  std::atomic<long> total(0);
+
+  std::printf("%u threads\n", threads);
+  bench::header("independent tasks, submit then wait");
+  {
+    archetype::task_scheduler scheduler(threads);
+    bench::report_per_s("task_scheduler", bench::ns_per_op(tasks, [&](std::size_t n) {
+      for (std::size_t i = 0; i < n; i++) { scheduler.submit(add_task{{&total, 1, 2, 3}}); }
+      scheduler.wait();
+    }));
+  }
+  {
+    function_pool pool(threads);
+    bench::report_per_s("std::function pool", bench::ns_per_op(tasks, [&](std::size_t n) {
+      for (std::size_t i = 0; i < n; i++) {
+        payload p{&total, 1, 2, 3};
+        pool.submit([p] { p.total->fetch_add(p.a + p.b + p.c, std::memory_order_relaxed); });
+      }
+      pool.wait();
+    }));
+  }
+
+  bench::header("latency of a chain of tasks, each submitting the next");
+  {
+    archetype::task_scheduler scheduler(threads);
+    bench::report("task_scheduler", bench::ns_per_op(hops, [&](std::size_t n) {
+      scheduler.submit(hop_task{&scheduler, &total, static_cast<long>(n), 0});
+      scheduler.wait();
+    }));
+  }
+  {
+    function_pool pool(threads);
+    bench::report("std::function pool", bench::ns_per_op(hops, [&](std::size_t n) {
+      pool.submit([&] { function_hop(&pool, &total, static_cast<long>(n), 0); });
+      pool.wait();
+    }));
+  }
+
+  bench::do_not_optimize(total);
+  return 0;
+}
@@ -0,0 +1,55 @@
+#include "archetype/archetype.h"
+#include "bench.h"
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+// Sorting with an erased comparator, an operator() archetype passed
+// straight to std::sort against a named method wrapped in a lambda,
+// std::function, and the comparator type itself
+
+ARCHETYPE_DEFINE(int_order, (ARCHETYPE_OPERATOR(bool, (), int, int)))
+ARCHETYPE_DEFINE(int_comparer, (ARCHETYPE_METHOD(bool, compare, int, int)))
+
+struct descending {
+  bool operator()(int a, int b) const { return a > b; }
+  bool compare(int a, int b) { return a > b; }
+};
+
+template <typename Compare>
+double time_sort(const std::vector<int> & input, Compare compare) {
+  std::vector<int> values;
+  return bench::ns_per_op(input.size(), [&](std::size_t) {
+    values = input;
+    std::sort(values.begin(), values.end(), compare);
+    bench::do_not_optimize(values);
+  });
+}
+
+int main() {
+  std::vector<int> input(1 << 20);
+  unsigned seed = 12345;
+  for (auto & v : input) {
+    seed = seed * 1103515245u + 12345u;
+    v = static_cast<int>(seed >> 8);
+  }
+
+  bench::header("std::sort of 1M ints, per element");
+
+  descending d;
+  bench::report("descending", time_sort(input, d));
+
+  int_order::view order(d);
+  bench::report("int_order::view", time_sort(input, order));
+
+  int_comparer::view comparer(d);
+  bench::report("int_comparer::view in a lambda",
+                time_sort(input, [comparer](int a, int b) mutable {
+                  return comparer.compare(a, b);
+                }));
+
+  std::function<bool(int, int)> function(d);
+  bench::report("std::function", time_sort(input, function));
+
+  return 0;
+}
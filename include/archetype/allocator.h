@@ -0,0 +1,367 @@
+#ifndef __ARCHETYPE_ALLOCATOR_H__
+#define __ARCHETYPE_ALLOCATOR_H__
+
+#include "archetype/archetype.h"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace archetype {
+
+  // Memory from anything that can hand it out. allocate returns nullptr
+  // when it can't satisfy a request, deallocate takes the size and
+  // alignment given to allocate, and owns tells whether p came from it.
+  // Unlike std::pmr::memory_resource there is no base class, and two views
+  // are the same allocator when they are bound to the same object.
+  ARCHETYPE_DEFINE(allocator, (ARCHETYPE_METHOD(void *, allocate, std::size_t, std::size_t),
+                               ARCHETYPE_METHOD(void, deallocate, void *, std::size_t,
+                                                std::size_t),
+                               ARCHETYPE_METHOD(bool, owns, const void *)))
+
+  // Power of two size classes from 8 to max_size bytes, shared by the
+  // pooling allocators
+  struct size_classes
+  {
+    static const std::size_t count = 8;
+    static const std::size_t max_size = 1024;
+
+    static std::size_t index(std::size_t n)
+    {
+      std::size_t i = 0;
+      for (std::size_t s = 8; s < n; s <<= 1) { i++; }
+      return i;
+    }
+
+    static std::size_t size(std::size_t index) { return std::size_t(8) << index; }
+  };
+
+  // Hands out memory by bumping a pointer and frees it all at once, on
+  // release or destruction. deallocate does nothing. Allocations are
+  // served from an optional caller buffer, then from blocks of the heap
+  // that double in size.
+  class monotonic_arena
+  {
+    public:
+    explicit monotonic_arena(std::size_t block_size = 4 << 10)
+        : _initial(nullptr), _initial_size(0), _block_size(block_size ? block_size : 1),
+          _next_size(_block_size), _blocks(nullptr), _cur(nullptr), _end(nullptr) {}
+
+    // Serves allocations from buffer first, which must outlive the arena
+    monotonic_arena(void * buffer, std::size_t size, std::size_t block_size = 4 << 10)
+        : monotonic_arena(block_size)
+    {
+      _initial = static_cast<char *>(buffer);
+      _initial_size = size;
+      _cur = _initial;
+      _end = _initial + size;
+    }
+
+    ~monotonic_arena() { release(); }
+
+    monotonic_arena(const monotonic_arena &) = delete;
+    monotonic_arena & operator=(const monotonic_arena &) = delete;
+
+    void * allocate(std::size_t n, std::size_t align)
+    {
+      void * p = _bump(n, align);
+      if (!p) {
+        _grow(n + align);
+        p = _bump(n, align);
+      }
+      return p;
+    }
+
+    void deallocate(void *, std::size_t, std::size_t) {}
+
+    bool owns(const void * p)
+    {
+      if (_within(p, _initial, _initial_size)) { return true; }
+      for (block * b = _blocks; b; b = b->next) {
+        if (_within(p, b->data, b->size)) { return true; }
+      }
+      return false;
+    }
+
+    // Frees every allocation, the arena can be used again
+    void release()
+    {
+      while (_blocks) {
+        block * next = _blocks->next;
+        ::operator delete(_blocks);
+        _blocks = next;
+      }
+      _next_size = _block_size;
+      _cur = _initial;
+      _end = _initial + _initial_size;
+    }
+
+    private:
+    struct block
+    {
+      block * next;
+      std::size_t size;
+      alignas(std::max_align_t) char data[1];
+    };
+
+    void * _bump(std::size_t n, std::size_t align)
+    {
+      if (!_cur) { return nullptr; }
+      std::uintptr_t p = (reinterpret_cast<std::uintptr_t>(_cur) + align - 1) & ~(align - 1);
+      if (p + n > reinterpret_cast<std::uintptr_t>(_end)) { return nullptr; }
+      _cur = reinterpret_cast<char *>(p + n);
+      return reinterpret_cast<void *>(p);
+    }
+
+    void _grow(std::size_t min)
+    {
+      std::size_t size = _next_size < min ? min : _next_size;
+      block * b = static_cast<block *>(::operator new(offsetof(block, data) + size));
+      b->next = _blocks;
+      b->size = size;
+      _blocks = b;
+      _next_size = size * 2;
+      _cur = b->data;
+      _end = b->data + size;
+    }
+
+    static bool _within(const void * p, const char * begin, std::size_t size)
+    {
+      std::uintptr_t a = reinterpret_cast<std::uintptr_t>(p);
+      std::uintptr_t b = reinterpret_cast<std::uintptr_t>(begin);
+      return begin && a >= b && a < b + size;
+    }
+
+    char * _initial;
+    std::size_t _initial_size;
+    std::size_t _block_size;
+    std::size_t _next_size;
+    block * _blocks;
+    char * _cur;
+    char * _end;
+  };
+
+  // Reuses freed memory through a free list per size class, carving new
+  // blocks from chunks of chunk_size bytes. Larger requests go to operator
+  // new. Not thread safe, and alignments above that of std::max_align_t
+  // are not supported.
+  class size_class_pool
+  {
+    public:
+    explicit size_class_pool(std::size_t chunk_size = 64 << 10)
+        : _chunk_size(chunk_size < size_classes::max_size ? size_classes::max_size
+                                                          : chunk_size),
+          _chunks(nullptr), _cur(nullptr), _end(nullptr)
+    {
+      for (std::size_t i = 0; i < size_classes::count; i++) { _free[i] = nullptr; }
+    }
+
+    ~size_class_pool() { release(); }
+
+    size_class_pool(const size_class_pool &) = delete;
+    size_class_pool & operator=(const size_class_pool &) = delete;
+
+    void * allocate(std::size_t n, std::size_t align)
+    {
+      if (align > alignof(std::max_align_t)) { return nullptr; }
+      if (n > size_classes::max_size) { return ::operator new(n); }
+      std::size_t c = size_classes::index(n < align ? align : n);
+      if (free_block * b = _free[c]) {
+        _free[c] = b->next;
+        return b;
+      }
+      return _carve(size_classes::size(c));
+    }
+
+    void deallocate(void * p, std::size_t n, std::size_t align)
+    {
+      if (!p) { return; }
+      if (n > size_classes::max_size) {
+        ::operator delete(p);
+        return;
+      }
+      std::size_t c = size_classes::index(n < align ? align : n);
+      free_block * b = static_cast<free_block *>(p);
+      b->next = _free[c];
+      _free[c] = b;
+    }
+
+    // Only blocks carved from chunks, not the larger requests
+    bool owns(const void * p)
+    {
+      std::uintptr_t a = reinterpret_cast<std::uintptr_t>(p);
+      for (chunk * c = _chunks; c; c = c->next) {
+        std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(c->data);
+        if (a >= begin && a < begin + _chunk_size) { return true; }
+      }
+      return false;
+    }
+
+    // Frees every chunk. Larger requests must have been deallocated.
+    void release()
+    {
+      while (_chunks) {
+        chunk * next = _chunks->next;
+        ::operator delete(_chunks);
+        _chunks = next;
+      }
+      for (std::size_t i = 0; i < size_classes::count; i++) { _free[i] = nullptr; }
+      _cur = _end = nullptr;
+    }
+
+    private:
+    struct free_block
+    {
+      free_block * next;
+    };
+
+    struct chunk
+    {
+      chunk * next;
+      alignas(std::max_align_t) char data[1];
+    };
+
+    // Classes are powers of two, so aligning the bump pointer to the
+    // class, or to max_align_t for larger ones, aligns every block
+    void * _carve(std::size_t size)
+    {
+      std::size_t align = size < alignof(std::max_align_t) ? size : alignof(std::max_align_t);
+      std::uintptr_t p = (reinterpret_cast<std::uintptr_t>(_cur) + align - 1) & ~(align - 1);
+      if (!_cur || p + size > reinterpret_cast<std::uintptr_t>(_end)) {
+        chunk * c = static_cast<chunk *>(::operator new(offsetof(chunk, data) + _chunk_size));
+        c->next = _chunks;
+        _chunks = c;
+        _end = c->data + _chunk_size;
+        p = reinterpret_cast<std::uintptr_t>(c->data);
+      }
+      _cur = reinterpret_cast<char *>(p + size);
+      return reinterpret_cast<void *>(p);
+    }
+
+    std::size_t _chunk_size;
+    free_block * _free[size_classes::count];
+    chunk * _chunks;
+    char * _cur;
+    char * _end;
+  };
+
+  // The system allocator with a per thread cache of freed blocks in front
+  // of it. Blocks up to size_classes::max_size are kept on the freeing
+  // thread, up to per_class of each class, and handed out again without
+  // going to operator new. Any thread may free any block. Everything comes
+  // from operator new, so owns is true for any non null pointer.
+  class thread_cache
+  {
+    public:
+    static const std::size_t per_class = 64;
+
+    void * allocate(std::size_t n, std::size_t align)
+    {
+      if (align > alignof(std::max_align_t)) { return nullptr; }
+      if (n > size_classes::max_size) { return ::operator new(n); }
+      std::size_t c = size_classes::index(n < align ? align : n);
+      lists & l = _local();
+      if (free_block * b = l.head[c]) {
+        l.head[c] = b->next;
+        l.count[c]--;
+        return b;
+      }
+      return ::operator new(size_classes::size(c));
+    }
+
+    void deallocate(void * p, std::size_t n, std::size_t align)
+    {
+      if (!p) { return; }
+      std::size_t c = size_classes::index(n < align ? align : n);
+      lists & l = _local();
+      if (c >= size_classes::count || l.count[c] == per_class) {
+        ::operator delete(p);
+        return;
+      }
+      free_block * b = static_cast<free_block *>(p);
+      b->next = l.head[c];
+      l.head[c] = b;
+      l.count[c]++;
+    }
+
+    bool owns(const void * p) { return p != nullptr; }
+
+    private:
+    struct free_block
+    {
+      free_block * next;
+    };
+
+    // Returned to operator delete when the thread exits
+    struct lists
+    {
+      lists()
+      {
+        for (std::size_t i = 0; i < size_classes::count; i++) {
+          head[i] = nullptr;
+          count[i] = 0;
+        }
+      }
+
+      ~lists()
+      {
+        for (std::size_t i = 0; i < size_classes::count; i++) {
+          while (free_block * b = head[i]) {
+            head[i] = b->next;
+            ::operator delete(b);
+          }
+        }
+      }
+
+      free_block * head[size_classes::count];
+      std::size_t count[size_classes::count];
+    };
+
+    static lists & _local()
+    {
+      static thread_local lists l;
+      return l;
+    }
+  };
+
+  // Adapts an allocator view to the STL allocator interface, so containers
+  // can share an allocator chosen at run time. Copies, and rebound copies,
+  // allocate from the same allocator. Throws std::bad_alloc when the
+  // allocator returns nullptr, as STL containers expect.
+  template <typename T>
+  class stl_allocator
+  {
+    public:
+    using value_type = T;
+
+    stl_allocator(allocator::view source) : _source(source) {}
+
+    template <typename U>
+    stl_allocator(const stl_allocator<U> & other) : _source(other.source()) {}
+
+    T * allocate(std::size_t n)
+    {
+      void * p = _source.allocate(n * sizeof(T), alignof(T));
+      if (!p) { throw std::bad_alloc(); }
+      return static_cast<T *>(p);
+    }
+
+    void deallocate(T * p, std::size_t n) { _source.deallocate(p, n * sizeof(T), alignof(T)); }
+
+    allocator::view source() const { return _source; }
+
+    template <typename U>
+    bool operator==(const stl_allocator<U> & other) const
+    {
+      return access::obj(_source) == access::obj(other.source());
+    }
+
+    template <typename U>
+    bool operator!=(const stl_allocator<U> & other) const { return !(*this == other); }
+
+    private:
+    allocator::view _source;
+  };
+
+} // namespace archetype
+
+#endif //__ARCHETYPE_ALLOCATOR_H__
@@ -1,7 +1,14 @@
 #ifndef __ARCHETYPE_H__
 #define __ARCHETYPE_H__
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
 #include <type_traits>
+#include <utility>
 
 //-- Utilities
 namespace archetype {
@@ -16,19 +23,124 @@ namespace archetype {
 
     template <typename T>
     void bind() {}
+
+    void bind_null() {}
+
+    // Dense per archetype index of this vtable, 0 is the null vtable
+    unsigned short _index;
   };
 
+  // Aborts with what unless ok. For limits whose violation would write out
+  // of bounds, so unlike assert it is kept in release builds.
+  inline void require(bool ok, const char * what) {
+    if (!ok) {
+      std::fprintf(stderr, "archetype: %s\n", what);
+      std::abort();
+    }
+  }
+
+  // Hands out vtable indices for the archetype whose vtable is VTableType
+  template <typename VTableType>
+  unsigned short next_vtable_index() {
+    static std::atomic<unsigned> next(1);
+    unsigned index = next.fetch_add(1, std::memory_order_relaxed);
+    require(index <= 0xffff, "more than 65535 vtables in one archetype");
+    return static_cast<unsigned short>(index);
+  }
+
   template<typename VTableType>
   class view_base
   {
+    public:
+    // false for default constructed views, which are bound to the null vtable
+    explicit operator bool() const { return _obj != nullptr; }
+
     protected:
+    friend struct access;
     void * _obj;
-    VTableType * _vtbl;
+    const VTableType * _vtbl;
+  };
+
+  // Library access to the binding held by a view
+  struct access
+  {
+    template <typename VTableType>
+    static void * obj(const view_base<VTableType> & v) { return v._obj; }
+
+    template <typename VTableType>
+    static const VTableType * vtbl(const view_base<VTableType> & v) {
+      return v._vtbl;
+    }
+
+    template <typename View, typename VTableType>
+    static View make(void * obj, const VTableType * vtbl) {
+      View v;
+      view_base<VTableType> & base = v;
+      base._obj = obj;
+      base._vtbl = vtbl;
+      return v;
+    }
+  };
+
+  // Value returned by the null vtable stubs
+  template <typename R>
+  struct null_result {
+    static R get() { return R(); }
+  };
+
+  template <>
+  struct null_result<void> {
+    static void get() {}
   };
 
+  // A per thread object, value initialized again on every call, so what is
+  // written through one null result is never read through the next
+  template <typename R>
+  struct null_result<R &> {
+    static R & get() {
+      using T = typename std::remove_cv<R>::type;
+      thread_local T r{};
+      r.~T();
+      return *new (&r) T();
+    }
+  };
+
+  // Vtable entry of an ARCHETYPE_FIELD, the offset of the member within the
+  // bound type. Reading it is a load, there is no call. Null views, whose
+  // object is nullptr, read the null result instead.
+  template <typename F>
+  struct field_stub
+  {
+    F & operator()(void * obj) const {
+      if (!obj) { return null_result<F &>::get(); }
+      return *reinterpret_cast<F *>(static_cast<char *>(obj) + offset);
+    }
+
+    std::uintptr_t offset;
+  };
+
+  // Offset of a data member of T. No T is constructed, only the address of
+  // the member is formed, so members of virtual bases are not supported.
+  template <typename T, typename F>
+  std::uintptr_t field_offset(F T::*member) {
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    T * t = reinterpret_cast<T *>(&storage);
+    return reinterpret_cast<std::uintptr_t>(&(t->*member)) -
+           reinterpret_cast<std::uintptr_t>(t);
+  }
+
   template <typename...> // std::void_t - pre c++17
   using void_t = void;
 
+  template <std::size_t...> struct indices {};
+
+  // std::make_index_sequence - pre c++14
+  template <std::size_t N, std::size_t... Is>
+  struct make_indices : make_indices<N - 1, N - 1, Is...> {};
+
+  template <std::size_t... Is>
+  struct make_indices<0, Is...> { using type = indices<Is...>; };
+
   template<typename Base>
   struct identity : public Base {
     using Base::Base;
@@ -42,441 +154,210 @@ namespace archetype {
     
     template<typename T = view_base<vtable<>>>
     using view_layer = typename Archetype::template view_layer<T>;
+
+    template <typename T>
+    using dispatch_vtable = typename Archetype::template dispatch_vtable<T>;
+
+    template <typename T>
+    using forward_layer = typename Archetype::template forward_layer<T>;
+
+    // type_list of the method descriptors, components first for composed
+    // archetypes
+    using methods = typename Archetype::_methods;
   };
-} // namespace archetype
 
+  // Whether Method was declared with ARCHETYPE_PURE_METHOD
+  template <typename Method, typename = void>
+  struct is_pure_method : std::false_type {};
+
+  template <typename Method>
+  struct is_pure_method<Method, void_t<typename Method::_pure>> : std::true_type {};
 
-//-- API
-#define ARCHETYPE_METHOD(ret, name, ...)                                       \
-  (ARCH_PP_UNIQUE_NAME(name), ret, name, __VA_ARGS__)
-
-#define ARCHETYPE_CHECK(ARCHETYPE, TYPE)\
-  static_assert(ARCHETYPE::check<TYPE>::value, STRINGIFY(TYPE must satisfy ARCHETYPE::check));
-
-#define ARCHETYPE_DEFINE(NAME, METHODS)                                        \
-  struct NAME {                                                                \
-    NAME() = delete;                                                           \
-    ~NAME() = delete;                                                          \
-    NAME & operator=(const NAME &) = delete;                                   \
-                                                                               \
-    friend struct archetype::helper<NAME>;                                      \
-                                                                               \
-    /* SFINAE based type checking against requirements */                      \
-    template <typename, typename = void> struct check : std::false_type {};    \
-                                                                               \
-    template <typename T>                                                      \
-    struct check<                                                              \
-      T, archetype::void_t<decltype(ARCH_PP_EXPAND_REQUIREMENTS(METHODS))>>    \
-      : std::true_type {};                                                     \
-                                                                               \
-    /* Internal protected vtable, and view_layer implementation */             \
-    protected:                                                                 \
-    template <typename BaseVTable = archetype::vtable_base>                    \
-    struct vtable : public BaseVTable                                          \
-    {                                                                          \
-      ARCH_PP_EXPAND_CALLSTUB_MEMBERS(METHODS)                                 \
-                                                                               \
-      template<typename T>                                                     \
-      void bind()                                                              \
-      {                                                                        \
-        ARCHETYPE_CHECK(NAME, T)                                               \
-        this->BaseVTable::template bind<T>();                                  \
-        ARCH_PP_EXPAND_CALLSTUB_ASSIGNMENTS(METHODS)                           \
-      }                                                                        \
-                                                                               \
-      template<typename T>                                                     \
-      static vtable * make_vtable()                                            \
-      {                                                                        \
-        static vtable<BaseVTable> vtablet;                                     \
-        vtablet.bind<T>();                                                     \
-        return &vtablet;                                                       \
-      }                                                                        \
-                                                                               \
-    };                                                                         \
-                                                                               \
-    template<typename BaseViewLayer = archetype::view_base<vtable<>>>          \
-    struct view_layer : public BaseViewLayer                                   \
-    {                                                                          \
-      ARCH_PP_EXPAND_METHODS(METHODS)                                          \
-                                                                               \
-      protected:                                                               \
-      using BaseViewLayer::_obj;                                               \
-      using BaseViewLayer::_vtbl;                                              \
-    };                                                                         \
-                                                                               \
-    /* Public view, and ptr structures */                                      \
-    public:                                                                    \
-    ARCH_PP_COMMON_BLOCK                                                       \
+  // The vtable binding T to Archetype, which views get through here. get
+  // isn't declared inline, so ARCHETYPE_EXTERN_BINDING can keep a TU from
+  // instantiating it, and with it make_vtable, bind and the method stubs.
+  template <class Archetype, typename T>
+  struct bound_vtable
+  {
+    static const typename helper<Archetype>::template vtable<> * get();
   };
 
+  template <class Archetype, typename T>
+  const typename helper<Archetype>::template vtable<> * bound_vtable<Archetype, T>::get()
+  {
+    return helper<Archetype>::template vtable<>::template make_vtable<T>();
+  }
 
-#define ARCHETYPE_COMPOSE(NAME, ...)                                           \
-  struct NAME {                                                                \
-    NAME() = delete;                                                           \
-    ~NAME() = delete;                                                          \
-    NAME & operator=(const NAME &) = delete;                                   \
-                                                                               \
-    friend struct archetype::helper<NAME>;                                      \
-                                                                               \
-    /* SFINAE based type checking against requirements */                      \
-    template <typename T>                                                      \
-    struct check                                                               \
-        : std::integral_constant<bool, ARCH_PP_EXPAND_COMPONENT_REQUIREMENTS(  \
-                                           __VA_ARGS__)> {};                   \
-                                                                               \
-    protected:                                                                 \
-    template<typename BaseVTable = archetype::vtable_base>                     \
-    struct vtable : public ARCH_PP_EXPAND_VTABLE_INHERITANCE(__VA_ARGS__)      \
-    {                                                                          \
-      using this_base = ARCH_PP_EXPAND_VTABLE_INHERITANCE(__VA_ARGS__);        \
-      template<typename T>                                                     \
-      void bind()                                                              \
-      {                                                                        \
-        this->this_base::template bind<T>();                                   \
-      }                                                                        \
-                                                                               \
-      template<typename T>                                                     \
-      static vtable * make_vtable()                                            \
-      {                                                                        \
-        static vtable<BaseVTable> vtablet;                                     \
-        vtablet.bind<T>();                                                     \
-                                                                               \
-        return &vtablet;                                                       \
-      }                                                                        \
-    };                                                                         \
-                                                                               \
-    template<typename BaseViewLayer = archetype::view_base<vtable<>>>          \
-    struct view_layer: public ARCH_PP_EXPAND_VIEW_LAYER_INHERITANCE(__VA_ARGS__)\
-    {                                                                          \
-      protected:                                                               \
-      using BaseViewLayer::_obj;                                               \
-      using BaseViewLayer::_vtbl;                                              \
-    };                                                                         \
-                                                                               \
-    /* Public view, and ptr structures */                                      \
-    public:                                                                    \
-    ARCH_PP_COMMON_BLOCK                                                       \
+  // Calls the bound type directly, the dispatch policy of static_view
+  template <typename T>
+  struct static_dispatch
+  {
+    template <typename R, typename Method, typename... Args>
+    R _dispatch(void * obj, Args &&... args) const {
+      return Method::template _call<T>(obj, std::forward<Args>(args)...);
+    }
   };
 
-//-- High level internal expansions
-#define ARCH_PP_COMMON_BLOCK                                                   \
-  struct view : public view_layer<>                                            \
-  {                                                                            \
-    template<typename T>                                                       \
-    view(T & t)                                                                \
-    {                                                                          \
-      this->_obj = static_cast<void *>(&t);                                    \
-      this->_vtbl = vtable<>::make_vtable<T>();                                \
-    }                                                                          \
-  };                                                                           \
-                                                                               \
-  template <template <typename> class API = archetype::identity>         \
-  struct ptr                                                                   \
-  {                                                                            \
-    template<typename T>                                                       \
-    ptr(T & t) : _view(t) {}                                                   \
-                                                                               \
-    API<view> &operator*() { return &_view; }                                  \
-    const API<view> &operator*() const { return &_view; }                      \
-    API<view> *operator->() { return &_view; }                                 \
-    const API<view> *operator->() const { return &_view; }                     \
-                                                                               \
-    protected:                                                                 \
-    API<view> _view;                                                           \
+  // View base for dispatch policies that don't need per view state. The
+  // vtable is a single shared constant, so calls through _vtbl resolve at
+  // compile time.
+  template<typename VTableType>
+  class static_view_base
+  {
+    public:
+    explicit operator bool() const { return _obj != nullptr; }
+
+    protected:
+    void * _obj;
+    static const VTableType _vtbl_instance;
+    static const VTableType * const _vtbl;
   };
 
-#define ARCH_PP_EXPAND_METHODS(METHODS) ARCH_PP_EXPAND_METHODS_IMPL METHODS
+  template <typename VTableType>
+  const VTableType static_view_base<VTableType>::_vtbl_instance = VTableType();
 
-#define ARCH_PP_EXPAND_METHODS_IMPL(...)                                       \
-  ARCH_PP_FOR_EACH(ARCH_PP_METHOD, __VA_ARGS__)
+  template <typename VTableType>
+  const VTableType * const static_view_base<VTableType>::_vtbl =
+      &static_view_base<VTableType>::_vtbl_instance;
 
-#define ARCH_PP_EXPAND_CALLSTUB_ASSIGNMENTS(METHODS)                           \
-  ARCH_PP_EXPAND_CALLSTUB_ASSIGNMENTS_IMPL METHODS
+  // Monomorphic view with the same API as Archetype::view, calls are direct
+  // and inlinable
+  template <class Archetype, typename T>
+  struct static_view
+      : public helper<Archetype>::template view_layer<static_view_base<
+            typename helper<Archetype>::template dispatch_vtable<
+                static_dispatch<T>>>>
+  {
+    static_assert(Archetype::template check<T>::value,
+                  "T must satisfy Archetype::check");
 
-#define ARCH_PP_EXPAND_CALLSTUB_ASSIGNMENTS_IMPL(...)                          \
-  ARCH_PP_FOR_EACH(ARCH_PP_CALLSTUB_ASSIGNMENT, __VA_ARGS__)
+    static_view(T & t) { this->_obj = static_cast<void *>(&t); }
+  };
 
-#define ARCH_PP_EXPAND_CALLSTUB_MEMBERS(METHODS)                               \
-  ARCH_PP_EXPAND_CALLSTUB_MEMBERS_IMPL METHODS
+  template <bool...> struct bool_pack {};
 
-#define ARCH_PP_EXPAND_CALLSTUB_MEMBERS_IMPL(...)                              \
-  ARCH_PP_FOR_EACH(ARCH_PP_CALLSTUB_MEMBER, __VA_ARGS__)
+  template <bool... Bs>
+  struct all_of
+      : std::is_same<bool_pack<true, Bs...>, bool_pack<Bs..., true>> {};
 
-#define ARCH_PP_EXPAND_REQUIREMENTS(METHODS)                                   \
-  ARCH_PP_EXPAND_REQUIREMENTS_IMPL METHODS
+  // Index of T in Ts..., or sizeof...(Ts) when T is not listed
+  template <typename T, typename... Ts>
+  struct index_of : std::integral_constant<std::size_t, 0> {};
 
-#define ARCH_PP_EXPAND_REQUIREMENTS_IMPL(...)                                  \
-  ARCH_PP_FOR_EACH_SEP(ARCH_PP_REQUIREMENT, __VA_ARGS__)
+  template <typename T, typename U, typename... Ts>
+  struct index_of<T, U, Ts...>
+      : std::integral_constant<std::size_t, 1 + index_of<T, Ts...>::value> {};
 
-#define ARCH_PP_EXPAND_VTABLE_INHERITANCE(...)                              \
-  ARCH_PP_EXPAND_VTABLE_INHERITANCE_IMPL(                                   \
-      ARCH_PP_FOR_EACH_SEP_CALL(ARCH_PP_APPLY_VTABLE_HELPER, __VA_ARGS__))
+  template <typename T, typename... Ts>
+  struct index_of<T, T, Ts...> : std::integral_constant<std::size_t, 0> {};
 
-#define ARCH_PP_EXPAND_VTABLE_INHERITANCE_IMPL(...)                         \
-  ARCH_PP_TEMPLATE_CHAIN(__VA_ARGS__ ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__) BaseVTable)
+  template <std::size_t I, typename T, typename... Ts>
+  struct type_at : type_at<I - 1, Ts...> {};
 
-#define ARCH_PP_EXPAND_VIEW_LAYER_INHERITANCE(...)                              \
-  ARCH_PP_EXPAND_VIEW_LAYER_INHERITANCE_IMPL(                                   \
-      ARCH_PP_FOR_EACH_SEP_CALL(ARCH_PP_APPLY_VIEW_LAYER_HELPER, __VA_ARGS__))
+  template <typename T, typename... Ts>
+  struct type_at<0, T, Ts...> { using type = T; };
 
-#define ARCH_PP_EXPAND_VIEW_LAYER_INHERITANCE_IMPL(...)                         \
-  ARCH_PP_TEMPLATE_CHAIN(__VA_ARGS__ ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__) BaseViewLayer)
+  template <typename... Ts> struct type_list {};
 
-#define ARCH_PP_EXPAND_COMPONENT_REQUIREMENTS(...)                             \
-  ARCH_PP_FOR_EACH_SEPX_CALL(ARCH_PP_APPEND_CHECK, &&, __VA_ARGS__)
+  // Concatenation of type_lists, keeping the first of any repeated type
+  template <typename... Lists> struct concat_unique;
 
-//-- Low level internal expressions
-#define ARCH_PP_METHOD(ARCH_PP_UNIQUE_NAME, ret, name, ...)                    \
-public:                                                                        \
-  ret name(TYPED_ARGS(M_NARGS(__VA_ARGS__), __VA_ARGS__)) {                    \
-    return _vtbl->_##ARCH_PP_UNIQUE_NAME##_stub(_obj ARCH_PP_COMMA_IF_ARGS(           \
-        __VA_ARGS__) ARCH_PP_ARG_NAMES(M_NARGS(__VA_ARGS__), __VA_ARGS__));    \
-  }
+  template <typename... As>
+  struct concat_unique<type_list<As...>> { using type = type_list<As...>; };
+
+  template <typename... As, typename... Rest>
+  struct concat_unique<type_list<As...>, type_list<>, Rest...>
+      : concat_unique<type_list<As...>, Rest...> {};
+
+  template <typename... As, typename B, typename... Bs, typename... Rest>
+  struct concat_unique<type_list<As...>, type_list<B, Bs...>, Rest...>
+      : concat_unique<typename std::conditional<
+                          (index_of<B, As...>::value < sizeof...(As)),
+                          type_list<As...>, type_list<As..., B>>::type,
+                      type_list<Bs...>, Rest...> {};
+
+  // Dispatches on a type index through a switch, the dispatch policy of
+  // variant_view. Indices past the end of Ts share the first case, and are
+  // never stored.
+  template <typename... Ts>
+  struct variant_dispatch
+  {
+    static_assert(sizeof...(Ts) > 0 && sizeof...(Ts) <= 16,
+                  "variant_view supports between 1 and 16 types");
 
-#define ARCH_PP_CALLSTUB_ASSIGNMENT(ARCH_PP_UNIQUE_NAME, ret, name, ...)       \
-  _##ARCH_PP_UNIQUE_NAME##_stub =                                              \
-      [](void *obj ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__)                          \
-             TYPED_ARGS(M_NARGS(__VA_ARGS__), __VA_ARGS__)) -> ret {           \
-    return static_cast<T *>(obj)->name(                                        \
-        ARCH_PP_ARG_NAMES(M_NARGS(__VA_ARGS__), __VA_ARGS__));                 \
+    template <typename R, typename Method, std::size_t I, typename... Args>
+    static R _call_at(void * obj, Args &&... args) {
+      using T = typename type_at<(I < sizeof...(Ts) ? I : 0), Ts...>::type;
+      return Method::template _call<T>(obj, std::forward<Args>(args)...);
+    }
+
+    template <typename R, typename Method, typename... Args>
+    R _dispatch(void * obj, Args &&... args) const {
+#define ARCH_PP_VARIANT_CASE(I)                                                \
+  case I:                                                                      \
+    return _call_at<R, Method, I>(obj, std::forward<Args>(args)...);
+      switch (_index) {
+      default:
+        ARCH_PP_VARIANT_CASE(0)  ARCH_PP_VARIANT_CASE(1)
+        ARCH_PP_VARIANT_CASE(2)  ARCH_PP_VARIANT_CASE(3)
+        ARCH_PP_VARIANT_CASE(4)  ARCH_PP_VARIANT_CASE(5)
+        ARCH_PP_VARIANT_CASE(6)  ARCH_PP_VARIANT_CASE(7)
+        ARCH_PP_VARIANT_CASE(8)  ARCH_PP_VARIANT_CASE(9)
+        ARCH_PP_VARIANT_CASE(10) ARCH_PP_VARIANT_CASE(11)
+        ARCH_PP_VARIANT_CASE(12) ARCH_PP_VARIANT_CASE(13)
+        ARCH_PP_VARIANT_CASE(14) ARCH_PP_VARIANT_CASE(15)
+      }
+#undef ARCH_PP_VARIANT_CASE
+    }
+
+    unsigned char _index;
+  };
+
+  // View base holding the dispatch policy by value, for policies with per
+  // view state
+  template<typename VTableType>
+  class variant_view_base
+  {
+    public:
+    explicit operator bool() const { return _obj != nullptr; }
+
+    protected:
+    struct vtable_ref : public VTableType
+    {
+      const VTableType * operator->() const { return this; }
+    };
+
+    void * _obj;
+    vtable_ref _vtbl;
   };
 
-#define ARCH_PP_CALLSTUB_MEMBER(ARCH_PP_UNIQUE_NAME, ret, name, ...)           \
-  ret (*_##ARCH_PP_UNIQUE_NAME##_stub)(                                        \
-      void *obj ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__) __VA_ARGS__);
-
-#define ARCH_PP_UNIQUE_NAME(base)                                              \
-  ARCH_PP_CAT(ARCH_PP_CAT(ARCH_PP_CAT(ARCH_PP_CAT(base, _), __LINE__), _),     \
-              __COUNTER__)
-
-#define ARCH_PP_REQUIREMENT(ARCH_PP_UNIQUE_NAME, ret, name, ...)               \
-  static_cast<ret (T::*)(TYPED_ARGS(M_NARGS(__VA_ARGS__), __VA_ARGS__))>(      \
-      &T::name)
-
-#define ARCH_PP_APPEND_CHECK(x) x::check<T>::value
-#define ARCH_PP_APPLY_VTABLE_HELPER(x) archetype::helper<x>::vtable
-#define ARCH_PP_APPLY_VIEW_LAYER_HELPER(x) archetype::helper<x>::view_layer
-
-//-- Foundational macro utilities
-#define ARCH_PP_EXPAND(x) x
-
-#define ARCH_PP_FOR_EACH(M, ...)                                               \
-  ARCH_PP_EXPAND(ARCH_PP_GET_MACRO(__VA_ARGS__, FE10, FE9, FE8, FE7, FE6, FE5, FE4,    \
-                           FE3, FE2, FE1)(M, __VA_ARGS__))
-
-#define ARCH_PP_GET_MACRO(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, NAME, ...) NAME
-
-#define FE1(M, x) M x
-#define FE2(M, x, ...) M x FE1(M, __VA_ARGS__)
-#define FE3(M, x, ...) M x FE2(M, __VA_ARGS__)
-#define FE4(M, x, ...) M x FE3(M, __VA_ARGS__)
-#define FE5(M, x, ...) M x FE4(M, __VA_ARGS__)
-#define FE6(M, x, ...) M x FE5(M, __VA_ARGS__)
-#define FE7(M, x, ...) M x FE6(M, __VA_ARGS__)
-#define FE8(M, x, ...) M x FE7(M, __VA_ARGS__)
-#define FE9(M, x, ...) M x FE8(M, __VA_ARGS__)
-#define FE10(M, x, ...) M x FE9(M, __VA_ARGS__)
-
-#define FE1_2(M, T, x) M(T, x)
-#define FE2_2(M, T, x, ...) M(T, x) FE1_2(M, T, __VA_ARGS__)
-#define FE3_2(M, T, x, ...) M(T, x) FE2_2(M, T, __VA_ARGS__)
-#define FE4_2(M, T, x, ...) M(T, x) FE3_2(M, T, __VA_ARGS__)
-#define FE5_2(M, T, x, ...) M(T, x) FE4_2(M, T, __VA_ARGS__)
-#define FE6_2(M, T, x, ...) M(T, x) FE5_2(M, T, __VA_ARGS__)
-#define FE7_2(M, T, x, ...) M(T, x) FE6_2(M, T, __VA_ARGS__)
-#define FE8_2(M, T, x, ...) M(T, x) FE7_2(M, T, __VA_ARGS__)
-#define FE9_2(M, T, x, ...) M(T, x) FE8_2(M, T, __VA_ARGS__)
-#define FE10_2(M, T, x, ...) M(T, x) FE9_2(M, T, __VA_ARGS__)
-
-#define ARCH_PP_FOR_EACH_SEP(M, ...)                                           \
-  ARCH_PP_EXPAND(ARCH_PP_GET_MACRO(__VA_ARGS__, FES10, FES9, FES8, FES7, FES6, FES5,   \
-                           FES4, FES3, FES2, FES1)(M, __VA_ARGS__))
-
-#define FES1(M, x) M x
-#define FES2(M, x, ...) M x, FE1(M, __VA_ARGS__)
-#define FES3(M, x, ...) M x, FE2(M, __VA_ARGS__)
-#define FES4(M, x, ...) M x, FE3(M, __VA_ARGS__)
-#define FES5(M, x, ...) M x, FE4(M, __VA_ARGS__)
-#define FES6(M, x, ...) M x, FE5(M, __VA_ARGS__)
-#define FES7(M, x, ...) M x, FE6(M, __VA_ARGS__)
-#define FES8(M, x, ...) M x, FE7(M, __VA_ARGS__)
-#define FES9(M, x, ...) M x, FE8(M, __VA_ARGS__)
-#define FES10(M, x, ...) M x, FE9(M, __VA_ARGS__)
-
-#define FES1_2(M, T, x) M(T, x)
-#define FES2_2(M, T, x, ...) M(T, x), FE1_2(M, T, __VA_ARGS__)
-#define FES3_2(M, T, x, ...) M(T, x), FE2_2(M, T, __VA_ARGS__)
-#define FES4_2(M, T, x, ...) M(T, x), FE3_2(M, T, __VA_ARGS__)
-#define FES5_2(M, T, x, ...) M(T, x), FE4_2(M, T, __VA_ARGS__)
-#define FES6_2(M, T, x, ...) M(T, x), FE5_2(M, T, __VA_ARGS__)
-#define FES7_2(M, T, x, ...) M(T, x), FE6_2(M, T, __VA_ARGS__)
-#define FES8_2(M, T, x, ...) M(T, x), FE7_2(M, T, __VA_ARGS__)
-#define FES9_2(M, T, x, ...) M(T, x), FE8_2(M, T, __VA_ARGS__)
-#define FES10_2(M, T, x, ...) M(T, x), FE9_2(M, T, __VA_ARGS__)
-
-#define ARCH_PP_FOR_EACH_CALL_1(M, a1) M(a1)
-#define ARCH_PP_FOR_EACH_CALL_2(M, a1, a2) M(a1) M(a2)
-#define ARCH_PP_FOR_EACH_CALL_3(M, a1, a2, a3) M(a1) M(a2) M(a3)
-#define ARCH_PP_FOR_EACH_CALL_4(M, a1, a2, a3, a4) M(a1) M(a2) M(a3) M(a4)
-#define ARCH_PP_FOR_EACH_CALL_5(M, a1, a2, a3, a4, a5)                         \
-  M(a1) M(a2) M(a3) M(a4) M(a5)
-#define ARCH_PP_FOR_EACH_CALL_6(M, a1, a2, a3, a4, a5, a6)                     \
-  M(a1) M(a2) M(a3) M(a4) M(a5) M(a6)
-#define ARCH_PP_FOR_EACH_CALL_7(M, a1, a2, a3, a4, a5, a6, a7)                 \
-  M(a1) M(a2) M(a3) M(a4) M(a5) M(a6) M(a7)
-#define ARCH_PP_FOR_EACH_CALL_8(M, a1, a2, a3, a4, a5, a6, a7, a8)             \
-  M(a1) M(a2) M(a3) M(a4) M(a5) M(a6) M(a7) M(a8)
-
-#define ARCH_PP_FOR_EACH_CALL(M, ...)                                          \
-  ARCH_PP_GET_FOR_EACH_CALL(M_NARGS(__VA_ARGS__))(M, __VA_ARGS__)
-
-#define ARCH_PP_GET_FOR_EACH_CALL(N) ARCH_PP_CAT(ARCH_PP_FOR_EACH_CALL_, N)
-
-#define ARCH_PP_FOR_EACH_SEP_CALL_1(M, a1) M(a1)
-#define ARCH_PP_FOR_EACH_SEP_CALL_2(M, a1, a2) M(a1), M(a2)
-#define ARCH_PP_FOR_EACH_SEP_CALL_3(M, a1, a2, a3) M(a1), M(a2), M(a3)
-#define ARCH_PP_FOR_EACH_SEP_CALL_4(M, a1, a2, a3, a4)                         \
-  M(a1), M(a2), M(a3), M(a4)
-#define ARCH_PP_FOR_EACH_SEP_CALL_5(M, a1, a2, a3, a4, a5)                     \
-  M(a1), M(a2), M(a3), M(a4), M(a5)
-#define ARCH_PP_FOR_EACH_SEP_CALL_6(M, a1, a2, a3, a4, a5, a6)                 \
-  M(a1), M(a2), M(a3), M(a4), M(a5), M(a6)
-#define ARCH_PP_FOR_EACH_SEP_CALL_7(M, a1, a2, a3, a4, a5, a6, a7)             \
-  M(a1), M(a2), M(a3), M(a4), M(a5), M(a6), M(a7)
-#define ARCH_PP_FOR_EACH_SEP_CALL_8(M, a1, a2, a3, a4, a5, a6, a7, a8)         \
-  M(a1), M(a2), M(a3), M(a4), M(a5), M(a6), M(a7), M(a8)
-
-#define ARCH_PP_FOR_EACH_SEP_CALL(M, ...)                                      \
-  ARCH_PP_GET_FOR_EACH_SEP_CALL(M_NARGS(__VA_ARGS__))(M, __VA_ARGS__)
-
-#define ARCH_PP_GET_FOR_EACH_SEP_CALL(N)                                       \
-  ARCH_PP_CAT(ARCH_PP_FOR_EACH_SEP_CALL_, N)
-
-#define ARCH_PP_FOR_EACH_SEPX_CALL_1(M, X, a1) M(a1)
-#define ARCH_PP_FOR_EACH_SEPX_CALL_2(M, X, a1, a2) M(a1) X M(a2)
-#define ARCH_PP_FOR_EACH_SEPX_CALL_3(M, X, a1, a2, a3)                         \
-  M(a1) X M(a2)                                                                \
-  X M(a3)
-#define ARCH_PP_FOR_EACH_SEPX_CALL_4(M, X, a1, a2, a3, a4)                     \
-  M(a1) X M(a2)                                                                \
-  X M(a3)                                                                      \
-  X M(a4)
-#define ARCH_PP_FOR_EACH_SEPX_CALL_5(M, X, a1, a2, a3, a4, a5)                 \
-  M(a1) X M(a2)                                                                \
-  X M(a3)                                                                      \
-  X M(a4)                                                                      \
-  X M(a5)
-#define ARCH_PP_FOR_EACH_SEPX_CALL_6(M, X, a1, a2, a3, a4, a5, a6)             \
-  M(a1) X M(a2)                                                                \
-  X M(a3)                                                                      \
-  X M(a4)                                                                      \
-  X M(a5)                                                                      \
-  X M(a6)
-#define ARCH_PP_FOR_EACH_SEPX_CALL_7(M, a1, a2, a3, a4, a5, a6, a7)            \
-  M(a1) X M(a2)                                                                \
-  X M(a3)                                                                      \
-  X M(a4)                                                                      \
-  X M(a5)                                                                      \
-  X M(a6)                                                                      \
-  X M(a7)
-#define ARCH_PP_FOR_EACH_SEPX_CALL_8(M, a1, a2, a3, a4, a5, a6, a7, a8)        \
-  M(a1) X M(a2)                                                                \
-  X M(a3)                                                                      \
-  X M(a4)                                                                      \
-  X M(a5)                                                                      \
-  X M(a6)                                                                      \
-  X M(a7)                                                                      \
-  X M(a8)
-
-#define ARCH_PP_FOR_EACH_SEPX_CALL(M, X, ...)                                  \
-  ARCH_PP_GET_FOR_EACH_SEPX_CALL(M_NARGS(__VA_ARGS__))(M, X, __VA_ARGS__)
-
-#define ARCH_PP_GET_FOR_EACH_SEPX_CALL(N)                                      \
-  ARCH_PP_CAT(ARCH_PP_FOR_EACH_SEPX_CALL_, N)
-
-// count arguments - ##__VA_ARGS__ is not portable
-#define M_NARGS(...)                                                           \
-  M_NARGS_(dummy, ##__VA_ARGS__, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
-#define M_NARGS_(_10, _9, _8, _7, _6, _5, _4, _3, _2, _1, N, ...) N
-
-// has arguments - ##__VA_ARGS__ is not portable
-#define HAS_ARGS(...)                                                          \
-  HAS_ARGS_IMPL(dummy, ##__VA_ARGS__, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0)
-#define HAS_ARGS_IMPL(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, N, ...) N
-#define ARCH_PP_COMMA_IF_ARGS(...)                                             \
-  ARCH_PP_COMMA_IF_ARGS_IMPL(HAS_ARGS(__VA_ARGS__))
-#define ARCH_PP_COMMA_IF_ARGS_IMPL(has_args)                                   \
-  M_CONC(ARCH_PP_COMMA_IF_ARGS_, has_args)
-#define ARCH_PP_COMMA_IF_ARGS_1 ,
-#define ARCH_PP_COMMA_IF_ARGS_0
-
-// utility (concatenation)
-#define M_CONC(A, B) M_CONC_(A, B)
-#define M_CONC_(A, B) A##B
-
-#define M_GET_ELEM(N, ...) M_CONC(M_GET_ELEM_, N)(__VA_ARGS__)
-#define M_GET_ELEM_0(_0, ...) _0
-#define M_GET_ELEM_1(_0, _1, ...) _1
-#define M_GET_ELEM_2(_0, _1, _2, ...) _2
-#define M_GET_ELEM_3(_0, _1, _2, _3, ...) _3
-#define M_GET_ELEM_4(_0, _1, _2, _3, _4, ...) _4
-#define M_GET_ELEM_5(_0, _1, _2, _3, _4, _5, ...) _5
-#define M_GET_ELEM_6(_0, _1, _2, _3, _4, _5, _6, ...) _6
-#define M_GET_ELEM_7(_0, _1, _2, _3, _4, _5, _6, _7, ...) _7
-#define M_GET_ELEM_8(_0, _1, _2, _3, _4, _5, _6, _7, _8, ...) _8
-#define M_GET_ELEM_9(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, ...) _9
-#define M_GET_ELEM_10(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, ...) _10
-
-// Get last argument - placeholder decrements by one
-#define M_GET_LAST(...)                                                        \
-  M_GET_ELEM(M_NARGS(__VA_ARGS__), _, __VA_ARGS__, , , , , , , , , , , )
-
-#define ARCH_PP_CAT(a, b) ARCH_PP_CAT_IMPL(a, b)
-#define ARCH_PP_CAT_IMPL(a, b) a##b
-
-#define STRINGIFY(x) STRINGIFY_IMPL(x)
-#define STRINGIFY_IMPL(x) #x
-
-#define FUNC_SIGNATURE(ret, name, ...) ret name(__VA_ARGS__)
-
-#define NUM_ARGS(...) NUM_ARGS_IMPL(__VA_ARGS__, 5, 4, 3, 2, 1, 0)
-#define NUM_ARGS_IMPL(_1, _2, _3, _4, _5, N, ...) N
-
-#define TYPED_ARG_0()
-#define TYPED_ARG_1(t0) t0 arg0
-#define TYPED_ARG_2(t0, t1) t0 arg0, t1 arg1
-#define TYPED_ARG_3(t0, t1, t2) t0 arg0, t1 arg1, t2 arg2
-#define TYPED_ARG_4(t0, t1, t2, t3) t0 arg0, t1 arg1, t2 arg2, t3 arg3
-// Extend as needed...
-
-#define TYPED_ARGS(count, ...) ARCH_PP_CAT(TYPED_ARG_, count)(__VA_ARGS__)
-
-#define ARCH_PP_ARG_NAMES_0()
-#define ARCH_PP_ARG_NAMES_1(t0) arg0
-#define ARCH_PP_ARG_NAMES_2(t0, t1) arg0, arg1
-#define ARCH_PP_ARG_NAMES_3(t0, t1, t2) arg0, arg1, arg2
-#define ARCH_PP_ARG_NAMES_4(t0, t1, t2, t3) arg0, arg1, arg2, arg3
-
-#define ARCH_PP_TEMPLATE_CHAIN(...)                                            \
-  ARCH_PP_TEMPLATE_CHAIN_DISPATCH(M_NARGS(__VA_ARGS__), __VA_ARGS__)
-#define ARCH_PP_TEMPLATE_CHAIN_DISPATCH(N, ...)                                \
-  ARCH_PP_CAT(ARCH_PP_TEMPLATE_CHAIN_, N)(__VA_ARGS__)
-#define ARCH_PP_TEMPLATE_CHAIN_1(t0) t0
-#define ARCH_PP_TEMPLATE_CHAIN_2(t0, t1) t0<t1>
-#define ARCH_PP_TEMPLATE_CHAIN_3(t0, t1, t2) t0<t1<t2>>
-#define ARCH_PP_TEMPLATE_CHAIN_4(t0, t1, t2, t3) t0<t1<t2<t3>>>
-#define ARCH_PP_TEMPLATE_CHAIN_5(t0, t1, t2, t3, t4) t0<t1<t2<t3<t4>>>>
-#define ARCH_PP_TEMPLATE_CHAIN_6(t0, t1, t2, t3, t4, t5) t0<t1<t2<t3<t4<t5>>>>>
-#define ARCH_PP_TEMPLATE_CHAIN_7(t0, t1, t2, t3, t4, t5, t6)                   \
-  t0<t1<t2<t3<t4<t5<t6>>>>>>
-#define ARCH_PP_TEMPLATE_CHAIN_8(t0, t1, t2, t3, t4, t5, t6, t7)               \
-  t0<t1<t2<t3<t4<t5<t6<t7>>>>>>>
-#define ARCH_PP_TEMPLATE_CHAIN_9(t0, t1, t2, t3, t4, t5, t6, t7, t8)           \
-  t0<t1<t2<t3<t4<t5<t6<t7<t8>>>>>>>>
-#define ARCH_PP_TEMPLATE_CHAIN_10(t0, t1, t2, t3, t4, t5, t6, t7, t8, t9)      \
-  t0<t1<t2<t3<t4<t5<t6<t7<t8<t9>>>>>>>>>
-
-#define ARCH_PP_ARG_NAMES(count, ...)                                          \
-  ARCH_PP_CAT(ARCH_PP_ARG_NAMES_, count)(__VA_ARGS__)
+  // View over a closed set of types with the same API as Archetype::view.
+  // A type index replaces the vtable pointer, and calls dispatch through a
+  // switch, so each case can be inlined.
+  template <class Archetype, typename... Ts>
+  struct variant_view
+      : public helper<Archetype>::template view_layer<variant_view_base<
+            typename helper<Archetype>::template dispatch_vtable<
+                variant_dispatch<Ts...>>>>
+  {
+    static_assert(all_of<Archetype::template check<Ts>::value...>::value,
+                  "Ts must satisfy Archetype::check");
+
+    template <typename T, typename = typename std::enable_if<
+                              !std::is_base_of<variant_view, T>::value>::type>
+    variant_view(T & t)
+    {
+      static_assert(index_of<T, Ts...>::value < sizeof...(Ts),
+                    "T must be one of the variant_view types");
+      this->_obj = static_cast<void *>(&t);
+      this->_vtbl._index = static_cast<unsigned char>(index_of<T, Ts...>::value);
+    }
+
+    // Index of the bound type in Ts...
+    std::size_t index() const { return this->_vtbl._index; }
+  };
+} // namespace archetype
+
+#include "archetype/macros.h"
 
 #endif //__ARCHETYPE_H__
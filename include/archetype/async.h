@@ -0,0 +1,287 @@
+#ifndef __ARCHETYPE_ASYNC_H__
+#define __ARCHETYPE_ASYNC_H__
+
+#include "archetype/archetype.h"
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bytes available to a call message, including the copied view, arguments,
+// and result promise
+#ifndef ARCHETYPE_ASYNC_MESSAGE_SIZE
+#define ARCHETYPE_ASYNC_MESSAGE_SIZE 96
+#endif
+
+namespace archetype {
+
+  // Runs messages posted from any thread on the thread that owns it. Messages
+  // are stored in fixed size slots of a bounded lock free MPSC queue, posting
+  // to a full executor waits for space.
+  class executor
+  {
+    public:
+    // capacity is rounded up to a power of two
+    explicit executor(std::size_t capacity = 1024)
+        : _slots(_round_up(capacity)), _mask(_slots.size() - 1), _head(0),
+          _tail(0)
+    {
+      for (std::size_t i = 0; i < _slots.size(); i++) {
+        _slots[i].seq.store(i, std::memory_order_relaxed);
+      }
+    }
+
+    ~executor()
+    {
+      // pending messages are destroyed without running, their futures
+      // report broken promises
+      while (_pop(false)) {}
+    }
+
+    executor(const executor &) = delete;
+    executor & operator=(const executor &) = delete;
+
+    // Queues f() to run on the owning thread, safe from any thread
+    template <typename F>
+    void post(F f)
+    {
+      static_assert(sizeof(F) <= ARCHETYPE_ASYNC_MESSAGE_SIZE,
+                    "message too large, increase ARCHETYPE_ASYNC_MESSAGE_SIZE");
+      static_assert(alignof(F) <= alignof(std::max_align_t),
+                    "message alignment not supported");
+
+      std::size_t pos = _tail.load(std::memory_order_relaxed);
+      slot * s;
+      for (;;) {
+        s = &_slots[pos & _mask];
+        std::size_t seq = s->seq.load(std::memory_order_acquire);
+        std::ptrdiff_t diff =
+            static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0) {
+          if (_tail.compare_exchange_weak(pos, pos + 1,
+                                          std::memory_order_relaxed)) {
+            break;
+          }
+        } else if (diff < 0) {
+          std::this_thread::yield();
+          pos = _tail.load(std::memory_order_relaxed);
+        } else {
+          pos = _tail.load(std::memory_order_relaxed);
+        }
+      }
+
+      new (s->data) F(std::move(f));
+      s->run = &_run<F>;
+      s->seq.store(pos + 1, std::memory_order_release);
+    }
+
+    // Runs one queued message if there is one, owning thread only
+    bool run_one() { return _pop(true); }
+
+    // Runs queued messages until the queue is empty, owning thread only.
+    // Returns the number run.
+    std::size_t run_pending()
+    {
+      std::size_t n = 0;
+      while (_pop(true)) { n++; }
+      return n;
+    }
+
+    private:
+    struct slot
+    {
+      std::atomic<std::size_t> seq;
+      void (*run)(void *, bool);
+      alignas(std::max_align_t) unsigned char data[ARCHETYPE_ASYNC_MESSAGE_SIZE];
+
+      slot() : run(nullptr) {}
+    };
+
+    static std::size_t _round_up(std::size_t capacity)
+    {
+      std::size_t size = 2;
+      while (size < capacity) { size *= 2; }
+      return size;
+    }
+
+    template <typename F>
+    static void _run(void * data, bool invoke)
+    {
+      F * f = static_cast<F *>(data);
+      if (invoke) { (*f)(); }
+      f->~F();
+    }
+
+    bool _pop(bool invoke)
+    {
+      slot & s = _slots[_head & _mask];
+      if (s.seq.load(std::memory_order_acquire) != _head + 1) { return false; }
+      s.run(s.data, invoke);
+      s.seq.store(_head + _mask + 1, std::memory_order_release);
+      _head++;
+      return true;
+    }
+
+    std::vector<slot> _slots;
+    std::size_t _mask;
+    std::size_t _head;
+    // producers and the consumer update different cache lines
+    alignas(64) std::atomic<std::size_t> _tail;
+  };
+
+  // Fulfils a promise with the result of f()
+  template <typename R>
+  struct fulfil {
+    template <typename F>
+    static void call(std::promise<R> & p, F f) { p.set_value(f()); }
+  };
+
+  template <>
+  struct fulfil<void> {
+    template <typename F>
+    static void call(std::promise<void> & p, F f) { f(); p.set_value(); }
+  };
+
+  // A call message, the bound view and copies of the arguments
+  template <typename R, typename Method, typename View, typename... Args>
+  struct async_call
+  {
+    View target;
+    std::promise<R> promise;
+    std::tuple<Args...> args;
+
+    async_call(const View & v, Args... a) : target(v), args(std::move(a)...) {}
+
+    void operator()() { _apply(typename make_indices<sizeof...(Args)>::type()); }
+
+    template <std::size_t... Is>
+    void _apply(indices<Is...>)
+    {
+      fulfil<R>::call(promise, [this]() -> R {
+        return Method::template _call<View>(&target, std::get<Is>(args)...);
+      });
+    }
+  };
+
+  // Call message whose result is discarded
+  template <typename Method, typename View, typename... Args>
+  struct async_post
+  {
+    View target;
+    std::tuple<Args...> args;
+
+    async_post(const View & v, Args... a) : target(v), args(std::move(a)...) {}
+
+    void operator()() { _apply(typename make_indices<sizeof...(Args)>::type()); }
+
+    template <std::size_t... Is>
+    void _apply(indices<Is...>)
+    {
+      Method::template _call<View>(&target, std::get<Is>(args)...);
+    }
+  };
+
+  // Whether a parameter keeps its meaning when its argument is copied into
+  // a call message. Writes through a non const reference would go to the
+  // copy, and a pointer may not outlive the caller.
+  template <typename T>
+  struct async_parameter
+      : std::integral_constant<
+            bool, !std::is_pointer<typename std::decay<T>::type>::value &&
+                      !(std::is_lvalue_reference<T>::value &&
+                        !std::is_const<typename std::remove_reference<T>::type>::value)> {};
+
+  template <typename Signature> struct async_signature;
+
+  template <typename R, typename... Params>
+  struct async_signature<R(Params...)>
+      : all_of<async_parameter<Params>::value...> {};
+
+  // Completion policies of async_view, use_future returns a std::future for
+  // every call, fire_and_forget returns nothing and allocates nothing.
+  struct use_future
+  {
+    template <typename R>
+    struct result { using type = std::future<R>; };
+
+    template <typename R, typename Method, typename View, typename... Args>
+    static std::future<R> post(executor & exec, const View & v, Args... args)
+    {
+      async_call<R, Method, View, Args...> call(v, std::move(args)...);
+      std::future<R> f = call.promise.get_future();
+      exec.post(std::move(call));
+      return f;
+    }
+  };
+
+  struct fire_and_forget
+  {
+    template <typename R>
+    struct result { using type = void; };
+
+    template <typename R, typename Method, typename View, typename... Args>
+    static void post(executor & exec, const View & v, Args... args)
+    {
+      exec.post(async_post<Method, View, Args...>(v, std::move(args)...));
+    }
+  };
+
+  template <class Archetype, typename Completion>
+  class async_view_base
+  {
+    public:
+    template <typename R>
+    using result = typename Completion::template result<R>;
+
+    explicit operator bool() const { return static_cast<bool>(_target); }
+
+    protected:
+    using view = typename Archetype::view;
+
+    template <typename R, typename Method, typename... Args>
+    typename result<R>::type _forward(Args... args)
+    {
+      static_assert(async_signature<typename Method::_signature>::value,
+                    "async calls copy their arguments, so parameters can't be "
+                    "pointers or non const references");
+      return Completion::template post<R, Method>(*_executor, _target,
+                                                  std::move(args)...);
+    }
+
+    view _target;
+    executor * _executor;
+  };
+
+  // View with the methods of Archetype that runs every call on an executor.
+  // Arguments are copied into a message, and by default each method returns
+  // a future for its result. Methods taking pointers or non const references
+  // can't be called through it.
+  template <class Archetype, typename Completion = use_future>
+  class async_view
+      : public helper<Archetype>::template forward_layer<
+            async_view_base<Archetype, Completion>>
+  {
+    public:
+    async_view(typename Archetype::view target, executor & exec)
+    {
+      this->_target = target;
+      this->_executor = &exec;
+    }
+
+    template <typename T, typename = typename std::enable_if<
+                              !std::is_base_of<typename Archetype::view, T>::value>::type>
+    async_view(T & t, executor & exec)
+    {
+      this->_target = typename Archetype::view(t);
+      this->_executor = &exec;
+    }
+  };
+
+} // namespace archetype
+
+#endif //__ARCHETYPE_ASYNC_H__
@@ -0,0 +1,129 @@
+#ifndef __ARCHETYPE_ATOMIC_H__
+#define __ARCHETYPE_ATOMIC_H__
+
+#include "archetype/archetype.h"
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace archetype {
+
+  template <class Archetype>
+  class atomic_view_base
+  {
+    public:
+    template <typename R>
+    struct result { using type = R; };
+
+    protected:
+    using view = typename Archetype::view;
+    using vtable_type = typename std::remove_cv<typename std::remove_pointer<
+        decltype(access::vtbl(std::declval<const view &>()))>::type>::type;
+
+    atomic_view_base() : _seq(0) { _set(view()); }
+
+    // Binding as of a consistent point in time. Readers never write, they
+    // retry while a store is in progress.
+    view _load() const
+    {
+      for (;;) {
+        std::size_t before = _seq.load(std::memory_order_acquire);
+        void * obj = _obj.load(std::memory_order_relaxed);
+        const vtable_type * vtbl = _vtbl.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (!(before & 1) && _seq.load(std::memory_order_relaxed) == before) {
+          return access::make<view>(obj, vtbl);
+        }
+        std::this_thread::yield();
+      }
+    }
+
+    // Writers take the sequence to odd, which also excludes other writers,
+    // and back to even when the new binding is in place
+    std::size_t _begin_store()
+    {
+      std::size_t seq = _seq.load(std::memory_order_relaxed);
+      while ((seq & 1) ||
+             !_seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire)) {
+        std::this_thread::yield();
+        seq = _seq.load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_release);
+      return seq;
+    }
+
+    void _end_store(std::size_t seq) { _seq.store(seq + 2, std::memory_order_release); }
+
+    void _set(const view & v)
+    {
+      _obj.store(access::obj(v), std::memory_order_relaxed);
+      _vtbl.store(access::vtbl(v), std::memory_order_relaxed);
+    }
+
+    template <typename R, typename Method, typename... Args>
+    R _forward(Args &&... args)
+    {
+      view v = _load();
+      return Method::template _call<view>(&v, std::forward<Args>(args)...);
+    }
+
+    std::atomic<std::size_t> _seq;
+    std::atomic<void *> _obj;
+    std::atomic<const vtable_type *> _vtbl;
+  };
+
+  // A view of Archetype that can be rebound while other threads call
+  // through it. The (object, vtable) pair is published under a seqlock, so
+  // a call never sees one half of a binding with the other half of
+  // another. A call may still be running on the old binding when store
+  // returns, keep the old object alive until such calls are done.
+  template <class Archetype>
+  class atomic_view
+      : public helper<Archetype>::template forward_layer<atomic_view_base<Archetype>>
+  {
+    using view = typename Archetype::view;
+
+    public:
+    atomic_view() {}
+
+    atomic_view(const view & v) { store(v); }
+
+    template <typename T, typename = typename std::enable_if<
+                              !std::is_base_of<view, T>::value>::type>
+    atomic_view(T & t) { store(view(t)); }
+
+    atomic_view(const atomic_view &) = delete;
+    atomic_view & operator=(const atomic_view &) = delete;
+
+    view load() const { return this->_load(); }
+
+    void store(const view & v)
+    {
+      std::size_t seq = this->_begin_store();
+      this->_set(v);
+      this->_end_store(seq);
+    }
+
+    template <typename T, typename = typename std::enable_if<
+                              !std::is_base_of<view, T>::value>::type>
+    void store(T & t) { store(view(t)); }
+
+    // Stores v and returns the previous binding
+    view exchange(const view & v)
+    {
+      std::size_t seq = this->_begin_store();
+      view old = access::make<view>(this->_obj.load(std::memory_order_relaxed),
+                                    this->_vtbl.load(std::memory_order_relaxed));
+      this->_set(v);
+      this->_end_store(seq);
+      return old;
+    }
+
+    explicit operator bool() const { return static_cast<bool>(load()); }
+  };
+
+} // namespace archetype
+
+#endif //__ARCHETYPE_ATOMIC_H__
@@ -0,0 +1,155 @@
+#ifndef __ARCHETYPE_BORROW_H__
+#define __ARCHETYPE_BORROW_H__
+
+#include "archetype/archetype.h"
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace archetype {
+
+  // Bytes lent out by a borrowing reader, valid until its next peek or
+  // consume
+  struct read_window
+  {
+    const char * data;
+    std::size_t size;
+  };
+
+  // Companion to readable whose source lends out its bytes instead of
+  // copying them. peek(min) returns the bytes from the current position,
+  // at least min of them unless the stream ends first, and an empty window
+  // at the end. consume(n) moves past n of them.
+  ARCHETYPE_DEFINE(borrowing_reader, (ARCHETYPE_METHOD(read_window, peek, std::size_t),
+                                      ARCHETYPE_METHOD(void, consume, std::size_t)))
+
+  // A read only file mapped into memory. peek lends out the rest of the
+  // file, so every byte is read in place. POSIX only.
+  class mapped_file
+  {
+    public:
+    mapped_file() : _data(nullptr), _size(0), _offset(0), _open(false) {}
+
+    ~mapped_file() { close(); }
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file & operator=(const mapped_file &) = delete;
+
+    // Returns false if the file can't be opened or mapped
+    bool open(const char * path)
+    {
+      close();
+      int fd = ::open(path, O_RDONLY);
+      if (fd < 0) { return false; }
+      struct stat st;
+      bool ok = ::fstat(fd, &st) == 0;
+      std::size_t size = ok ? static_cast<std::size_t>(st.st_size) : 0;
+      void * p = nullptr;
+      if (ok && size) {
+        p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ok = p != MAP_FAILED;
+      }
+      ::close(fd);
+      if (!ok) { return false; }
+      if (p) { ::madvise(p, size, MADV_SEQUENTIAL); }
+      _data = static_cast<const char *>(p);
+      _size = size;
+      _offset = 0;
+      _open = true;
+      return true;
+    }
+
+    void close()
+    {
+      if (_data) { ::munmap(const_cast<char *>(_data), _size); }
+      _data = nullptr;
+      _size = 0;
+      _offset = 0;
+      _open = false;
+    }
+
+    explicit operator bool() const { return _open; }
+
+    read_window peek(std::size_t) { return read_window{_data + _offset, _size - _offset}; }
+
+    void consume(std::size_t n) { _offset += n < _size - _offset ? n : _size - _offset; }
+
+    // Copying reads, so a mapped file is also readable
+    int read(char * buf, std::size_t n)
+    {
+      read_window w = peek(n);
+      if (n > w.size) { n = w.size; }
+      if (n) { std::memcpy(buf, w.data, n); }
+      consume(n);
+      return static_cast<int>(n);
+    }
+
+    std::size_t size() const { return _size; }
+
+    private:
+    const char * _data;
+    std::size_t _size;
+    std::size_t _offset;
+    bool _open;
+  };
+
+  // Adapts anything readable, with int read(char *, size_t), to the
+  // borrowing form. Bytes are read into a buffer and lent out from there,
+  // the buffer grows when a peek asks for more than it holds. Reader may be
+  // a view, or a reference to the reader.
+  template <typename Reader>
+  class reader_buffer
+  {
+    public:
+    explicit reader_buffer(Reader reader, std::size_t capacity = 64 << 10)
+        : _reader(std::forward<Reader>(reader)), _buffer(capacity ? capacity : 1), _begin(0),
+          _end(0), _eof(false) {}
+
+    read_window peek(std::size_t min)
+    {
+      if (min == 0) { min = 1; }
+      if (_end - _begin < min && !_eof) { _fill(min); }
+      return read_window{_buffer.data() + _begin, _end - _begin};
+    }
+
+    void consume(std::size_t n) { _begin += n < _end - _begin ? n : _end - _begin; }
+
+    Reader & reader() { return _reader; }
+
+    private:
+    void _fill(std::size_t min)
+    {
+      // keep unconsumed bytes, then read until min are held or the end
+      std::size_t held = _end - _begin;
+      if (_begin) {
+        std::memmove(_buffer.data(), _buffer.data() + _begin, held);
+        _begin = 0;
+        _end = held;
+      }
+      if (_buffer.size() < min) { _buffer.resize(min); }
+      while (_end < min) {
+        int n = _reader.read(_buffer.data() + _end, _buffer.size() - _end);
+        if (n <= 0) {
+          _eof = true;
+          return;
+        }
+        _end += static_cast<std::size_t>(n);
+      }
+    }
+
+    Reader _reader;
+    std::vector<char> _buffer;
+    std::size_t _begin;
+    std::size_t _end;
+    bool _eof;
+  };
+
+} // namespace archetype
+
+#endif //__ARCHETYPE_BORROW_H__
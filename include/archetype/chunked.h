@@ -0,0 +1,101 @@
+#ifndef __ARCHETYPE_CHUNKED_H__
+#define __ARCHETYPE_CHUNKED_H__
+
+#include "archetype/archetype.h"
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+namespace archetype {
+
+  // A sequence of Element read a chunk at a time, so a call through a view is
+  // paid once per chunk instead of once per element. next_chunk copies up
+  // to n elements into out and returns how many, 0 at the end.
+  template <typename Element>
+  ARCHETYPE_DEFINE(chunked_source,
+                   (ARCHETYPE_METHOD(std::size_t, next_chunk, Element *, std::size_t)))
+
+  // Chunks of an iterator range, such as an STL container
+  template <typename Iterator>
+  class range_chunks
+  {
+    public:
+    using value_type = typename std::iterator_traits<Iterator>::value_type;
+
+    range_chunks(Iterator first, Iterator last) : _first(first), _last(last) {}
+
+    std::size_t next_chunk(value_type * out, std::size_t n)
+    {
+      return _copy(out, n, typename std::iterator_traits<Iterator>::iterator_category());
+    }
+
+    private:
+    // Random access ranges are copied in one go, which vectorises
+    std::size_t _copy(value_type * out, std::size_t n, std::random_access_iterator_tag)
+    {
+      std::size_t left = static_cast<std::size_t>(_last - _first);
+      std::size_t count = n < left ? n : left;
+      std::copy(_first, _first + count, out);
+      _first += count;
+      return count;
+    }
+
+    std::size_t _copy(value_type * out, std::size_t n, std::input_iterator_tag)
+    {
+      std::size_t count = 0;
+      for (; count < n && _first != _last; ++_first) { out[count++] = *_first; }
+      return count;
+    }
+
+    Iterator _first;
+    Iterator _last;
+  };
+
+  // Chunks of the elements of a container, which must outlive the result
+  template <typename Container>
+  range_chunks<typename Container::const_iterator> chunks_of(const Container & c)
+  {
+    return range_chunks<typename Container::const_iterator>(c.begin(), c.end());
+  }
+
+  // Chunks of anything with bool next(Element &), one element at a time.
+  // The calls to next are direct, so only the chunk is dispatched. Source
+  // may be a reference to the source.
+  template <typename Element, typename Source>
+  class next_chunks
+  {
+    public:
+    explicit next_chunks(Source source) : _source(std::forward<Source>(source)) {}
+
+    std::size_t next_chunk(Element * out, std::size_t n)
+    {
+      std::size_t count = 0;
+      while (count < n && _source.next(out[count])) { count++; }
+      return count;
+    }
+
+    Source & source() { return _source; }
+
+    private:
+    Source _source;
+  };
+
+  // Calls f on every element of source, reading N at a time into a buffer
+  // on the stack. Returns the number of elements.
+  template <typename Element, std::size_t N = 64, typename Source, typename F>
+  std::size_t for_each_chunked(Source && source, F f)
+  {
+    static_assert(N > 0, "chunks must hold at least one element");
+    Element buffer[N];
+    std::size_t total = 0;
+    while (std::size_t n = source.next_chunk(buffer, N)) {
+      for (std::size_t i = 0; i < n; i++) { f(buffer[i]); }
+      total += n;
+    }
+    return total;
+  }
+
+} // namespace archetype
+
+#endif //__ARCHETYPE_CHUNKED_H__
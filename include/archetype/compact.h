@@ -0,0 +1,254 @@
+#ifndef __ARCHETYPE_COMPACT_H__
+#define __ARCHETYPE_COMPACT_H__
+
+#include "archetype/archetype.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Maximum number of distinct vtables per archetype usable by compact views
+#ifndef ARCHETYPE_MAX_COMPACT_VTABLES
+#define ARCHETYPE_MAX_COMPACT_VTABLES 256
+#endif
+
+// Pack the vtable index into the unused high 16 bits of the object pointer.
+// Only enabled on 64 bit targets where user space addresses fit in 48 bits.
+// Define as 0 on platforms that tag the top byte of pointers.
+#ifndef ARCHETYPE_COMPACT_PACKED
+#if defined(__x86_64__) || defined(_M_X64) || defined(__aarch64__)
+#define ARCHETYPE_COMPACT_PACKED 1
+#else
+#define ARCHETYPE_COMPACT_PACKED 0
+#endif
+#endif
+
+namespace archetype {
+
+  // Maps vtable indices back to the vtables of one archetype. Entries are
+  // filled in as compact views are bound, index 0 is the null vtable.
+  template <typename VTableType>
+  struct compact_registry
+  {
+    static const VTableType * get(unsigned short index) {
+      return _table[index].load(std::memory_order_relaxed);
+    }
+
+    static unsigned short add(const VTableType * vtbl) {
+      require(vtbl->_index < ARCHETYPE_MAX_COMPACT_VTABLES,
+              "too many vtables, increase ARCHETYPE_MAX_COMPACT_VTABLES");
+      if (_table[vtbl->_index].load(std::memory_order_relaxed) != vtbl) {
+        _table[vtbl->_index].store(vtbl, std::memory_order_relaxed);
+      }
+      return vtbl->_index;
+    }
+
+    template <class Archetype, typename T>
+    static unsigned short add() {
+      static const unsigned short index = add(bound_vtable<Archetype, T>::get());
+      return index;
+    }
+
+    static unsigned short add_null() {
+      static const unsigned short index = add(VTableType::make_null_vtable());
+      return index;
+    }
+
+    static std::atomic<const VTableType *> _table[ARCHETYPE_MAX_COMPACT_VTABLES];
+  };
+
+  template <typename VTableType>
+  std::atomic<const VTableType *>
+      compact_registry<VTableType>::_table[ARCHETYPE_MAX_COMPACT_VTABLES];
+
+#if ARCHETYPE_COMPACT_PACKED
+  // Object pointer and vtable index share one word. _obj and _vtbl are views
+  // of the same bits, read through their common initial member.
+  template <typename VTableType>
+  class compact_view_base
+  {
+    public:
+    explicit operator bool() const { return _bits.value & pointer_mask; }
+
+    protected:
+    static const std::uintptr_t pointer_mask = (std::uintptr_t(1) << 48) - 1;
+
+    struct packed_obj
+    {
+      std::uintptr_t value;
+      operator void *() const { return reinterpret_cast<void *>(value & pointer_mask); }
+    };
+
+    struct packed_vtbl
+    {
+      std::uintptr_t value;
+      const VTableType * operator->() const {
+        return compact_registry<VTableType>::get(
+            static_cast<unsigned short>(value >> 48));
+      }
+    };
+
+    struct packed_bits
+    {
+      std::uintptr_t value;
+    };
+
+    void _bind(void * obj, unsigned short index) {
+      std::uintptr_t address = reinterpret_cast<std::uintptr_t>(obj);
+      require((address & ~pointer_mask) == 0, "pointer does not fit in 48 bits");
+      _bits.value = address | (std::uintptr_t(index) << 48);
+    }
+
+    void * _get_obj() const { return _obj; }
+    unsigned short _get_index() const { return static_cast<unsigned short>(_bits.value >> 48); }
+
+    union
+    {
+      packed_bits _bits;
+      packed_obj _obj;
+      packed_vtbl _vtbl;
+    };
+  };
+#else
+  template <typename VTableType>
+  class compact_view_base
+  {
+    public:
+    explicit operator bool() const { return _obj != nullptr; }
+
+    protected:
+    struct indexed_vtbl
+    {
+      unsigned short index;
+      const VTableType * operator->() const {
+        return compact_registry<VTableType>::get(index);
+      }
+    };
+
+    void _bind(void * obj, unsigned short index) {
+      _obj = obj;
+      _vtbl.index = index;
+    }
+
+    void * _get_obj() const { return _obj; }
+    unsigned short _get_index() const { return _vtbl.index; }
+
+    void * _obj;
+    indexed_vtbl _vtbl;
+  };
+#endif
+
+  template <class Archetype> class view_array;
+
+  // View with the same API as Archetype::view, storing a vtable index in
+  // place of the vtable pointer. Packed into a single pointer where the
+  // platform allows.
+  template <class Archetype>
+  class compact_view
+      : public helper<Archetype>::template view_layer<
+            compact_view_base<typename helper<Archetype>::template vtable<>>>
+  {
+    using vtable_type = typename helper<Archetype>::template vtable<>;
+    using registry = compact_registry<vtable_type>;
+
+    public:
+    compact_view() { this->_bind(nullptr, registry::add_null()); }
+
+    template <typename T, typename = typename std::enable_if<
+                              !std::is_base_of<compact_view, T>::value &&
+                              !std::is_same<T, typename Archetype::view>::value>::type>
+    compact_view(T & t)
+    {
+      this->_bind(static_cast<void *>(&t), registry::template add<Archetype, T>());
+    }
+
+    compact_view(const typename Archetype::view & v)
+    {
+      this->_bind(access::obj(v), registry::add(access::vtbl(v)));
+    }
+
+    // Erased view with the same binding
+    typename Archetype::view to_view() const {
+      return access::make<typename Archetype::view>(
+          this->_get_obj(), registry::get(this->_get_index()));
+    }
+
+    private:
+    friend class view_array<Archetype>;
+
+    compact_view(void * obj, unsigned short index) { this->_bind(obj, index); }
+  };
+
+  // Structure of arrays of bindings, object pointers and vtable indices are
+  // stored separately. Elements are accessed as compact_views.
+  template <class Archetype>
+  class view_array
+  {
+    using vtable_type = typename helper<Archetype>::template vtable<>;
+    using registry = compact_registry<vtable_type>;
+
+    public:
+    using value_type = compact_view<Archetype>;
+
+    class iterator
+    {
+      public:
+      iterator(const view_array * array, std::size_t i) : _array(array), _i(i) {}
+      value_type operator*() const { return (*_array)[_i]; }
+      iterator & operator++() { ++_i; return *this; }
+      bool operator==(const iterator & other) const { return _i == other._i; }
+      bool operator!=(const iterator & other) const { return _i != other._i; }
+
+      private:
+      const view_array * _array;
+      std::size_t _i;
+    };
+
+    view_array() { registry::add_null(); }
+
+    template <typename T, typename = typename std::enable_if<
+                              !std::is_same<T, typename Archetype::view>::value>::type>
+    void push_back(T & t)
+    {
+      _objs.push_back(static_cast<void *>(&t));
+      _indices.push_back(registry::template add<Archetype, T>());
+    }
+
+    void push_back(const typename Archetype::view & v)
+    {
+      _objs.push_back(access::obj(v));
+      _indices.push_back(registry::add(access::vtbl(v)));
+    }
+
+    value_type operator[](std::size_t i) const {
+      return value_type(_objs[i], _indices[i]);
+    }
+
+    // Vtable index of element i
+    unsigned short index(std::size_t i) const { return _indices[i]; }
+
+    // Calls f(view) for every element, reading the two arrays in order
+    template <typename F>
+    void for_each(F f) const
+    {
+      const std::size_t n = _objs.size();
+      for (std::size_t i = 0; i < n; i++) {
+        f(value_type(_objs[i], _indices[i]));
+      }
+    }
+
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, _objs.size()); }
+
+    std::size_t size() const { return _objs.size(); }
+    bool empty() const { return _objs.empty(); }
+    void reserve(std::size_t n) { _objs.reserve(n); _indices.reserve(n); }
+    void clear() { _objs.clear(); _indices.clear(); }
+
+    private:
+    std::vector<void *> _objs;
+    std::vector<unsigned short> _indices;
+  };
+
+} // namespace archetype
+
+#endif //__ARCHETYPE_COMPACT_H__
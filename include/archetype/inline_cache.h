@@ -0,0 +1,144 @@
+#ifndef __ARCHETYPE_INLINE_CACHE_H__
+#define __ARCHETYPE_INLINE_CACHE_H__
+
+#include "archetype/archetype.h"
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace archetype {
+
+  template <class Archetype, typename... Ts>
+  class inline_cache;
+
+  template <class Archetype, typename... Ts>
+  class inline_cache_base
+  {
+    public:
+    template <typename R>
+    struct result { using type = R; };
+
+    protected:
+    using view = typename Archetype::view;
+    using vtable_type = typename helper<Archetype>::template vtable<>;
+    using site_type = inline_cache<Archetype, Ts...>;
+
+    // Compares the bound vtable against each registered type in order, a
+    // match calls the type directly. Calls are synchronous, so arguments
+    // are passed on by reference.
+    template <typename R, typename Method, typename... Args>
+    R _forward(Args &&... args)
+    {
+      return _probe<R, Method>(std::integral_constant<std::size_t, 0>(),
+                               std::forward<Args>(args)...);
+    }
+
+    // GCC inlines the direct call for every listed type, without ruling out
+    // the ones the vtable compare excludes, and -Warray-bounds then reports
+    // the object as too small for them
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Warray-bounds"
+#endif
+    template <typename R, typename Method, std::size_t I, typename... Args>
+    R _probe(std::integral_constant<std::size_t, I>, Args &&... args)
+    {
+      using T = typename type_at<I, Ts...>::type;
+      if (_vtbl == vtable_type::template make_vtable<T>()) {
+        _site->_count(_site->_hits);
+        return Method::template _call<T>(_obj, std::forward<Args>(args)...);
+      }
+      return _probe<R, Method>(std::integral_constant<std::size_t, I + 1>(),
+                               std::forward<Args>(args)...);
+    }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+    template <typename R, typename Method, typename... Args>
+    R _probe(std::integral_constant<std::size_t, sizeof...(Ts)>, Args &&... args)
+    {
+      _site->_count(_site->_misses);
+      view v = access::make<view>(_obj, _vtbl);
+      return Method::template _call<view>(&v, std::forward<Args>(args)...);
+    }
+
+    site_type * _site;
+    void * _obj;
+    const vtable_type * _vtbl;
+  };
+
+  // A call site cache for views of Archetype, for call sites that mostly
+  // see a few known types. Ts are checked in order, so list the most
+  // common first. A call whose view is bound to one of them is a pointer
+  // compare and a direct, inlinable call, any other goes through the
+  // vtable. Declare one per call site, usually static:
+  //
+  //   static archetype::inline_cache<shape, circle, square> site;
+  //   site(v).area();
+  template <class Archetype, typename... Ts>
+  class inline_cache
+  {
+    using view = typename Archetype::view;
+
+    static_assert(sizeof...(Ts) > 0, "inline_cache needs at least one type");
+    static_assert(all_of<Archetype::template check<Ts>::value...>::value,
+                  "Ts must satisfy Archetype::check");
+
+    public:
+    // The methods of Archetype, called through the cache
+    class call
+        : public helper<Archetype>::template forward_layer<
+              inline_cache_base<Archetype, Ts...>>
+    {
+      friend class inline_cache;
+    };
+
+    inline_cache() { reset_stats(); }
+
+    inline_cache(const inline_cache &) = delete;
+    inline_cache & operator=(const inline_cache &) = delete;
+
+    call operator()(const view & v)
+    {
+      call c;
+      c._site = this;
+      c._obj = access::obj(v);
+      c._vtbl = access::vtbl(v);
+      return c;
+    }
+
+    // Counts are approximate when the site is used from several threads,
+    // increments are not atomic so they cost no more than a plain add
+    std::size_t hits() const { return _hits.load(std::memory_order_relaxed); }
+    std::size_t misses() const { return _misses.load(std::memory_order_relaxed); }
+
+    double hit_rate() const
+    {
+      std::size_t total = hits() + misses();
+      return total ? static_cast<double>(hits()) / static_cast<double>(total) : 0.0;
+    }
+
+    void reset_stats()
+    {
+      _hits.store(0, std::memory_order_relaxed);
+      _misses.store(0, std::memory_order_relaxed);
+    }
+
+    private:
+    friend class inline_cache_base<Archetype, Ts...>;
+
+    static void _count(std::atomic<std::size_t> & counter)
+    {
+      counter.store(counter.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+    }
+
+    std::atomic<std::size_t> _hits;
+    std::atomic<std::size_t> _misses;
+  };
+
+} // namespace archetype
+
+#endif //__ARCHETYPE_INLINE_CACHE_H__
@@ -0,0 +1,638 @@
+#ifndef __ARCHETYPE_IPC_H__
+#define __ARCHETYPE_IPC_H__
+
+#include "archetype/archetype.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Calls between processes over POSIX shared memory. POSIX only.
+
+namespace archetype {
+
+  static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+                "ipc needs lock free 64 bit atomics in shared memory");
+
+  // Byte buffer argument. When data points into the scratch area of the
+  // channel the call is made over, only its offset is sent, otherwise the
+  // bytes are copied into the request.
+  struct ipc_span
+  {
+    const void * data;
+    std::size_t size;
+  };
+
+  // Shared state of a single producer, single consumer ring of messages
+  struct ipc_ring_state
+  {
+    alignas(64) std::atomic<std::uint64_t> head;
+    alignas(64) std::atomic<std::uint64_t> tail;
+  };
+
+  // Process local handle to a ring. Messages are a 4 byte length followed
+  // by the payload, padded to 8 bytes. A length of ~0 marks a skip to the
+  // start of the ring.
+  class ipc_ring
+  {
+    public:
+    ipc_ring() : _state(nullptr), _data(nullptr), _mask(0), _read(0), _write(0) {}
+
+    ipc_ring(ipc_ring_state * state, unsigned char * data, std::size_t capacity)
+        : _state(state), _data(data), _mask(capacity - 1), _read(0), _write(0) {}
+
+    // Largest payload a message can carry
+    std::size_t max_payload() const { return (_mask + 1) / 2 - 8; }
+
+    // Waits for room for n payload bytes and returns where to write them,
+    // or nullptr without waiting if n is over max_payload
+    unsigned char * begin_write(std::size_t n)
+    {
+      if (n > max_payload()) { return nullptr; }
+      const std::uint64_t capacity = _mask + 1;
+      const std::uint64_t need = _padded(n);
+      std::uint64_t t = _state->tail.load(std::memory_order_relaxed);
+      std::uint64_t to_end = capacity - (t & _mask);
+      std::uint64_t total = need <= to_end ? need : to_end + need;
+      _wait([&] {
+        return capacity - (t - _state->head.load(std::memory_order_acquire)) >= total;
+      });
+      if (need > to_end) {
+        std::uint32_t skip = ~std::uint32_t(0);
+        std::memcpy(_data + (t & _mask), &skip, sizeof(skip));
+        t += to_end;
+      }
+      std::uint32_t length = static_cast<std::uint32_t>(n);
+      std::memcpy(_data + (t & _mask), &length, sizeof(length));
+      _write = t + need;
+      return _data + (t & _mask) + 8;
+    }
+
+    void commit_write() { _state->tail.store(_write, std::memory_order_release); }
+
+    // Next message, or nullptr when the ring is empty. The other process
+    // writes the ring, so a message that doesn't lie whole between head and
+    // tail is returned as an empty one, and the rest of the ring dropped.
+    const unsigned char * try_read(std::size_t & n)
+    {
+      const std::uint64_t capacity = _mask + 1;
+      std::uint64_t h = _state->head.load(std::memory_order_relaxed);
+      const std::uint64_t t = _state->tail.load(std::memory_order_acquire);
+      if (h == t) { return nullptr; }
+      std::uint64_t at = h & _mask;
+      std::uint64_t available = t - h;
+      std::uint32_t length = 0;
+      bool ok = (h & 7) == 0 && available <= capacity;
+      if (ok) {
+        std::memcpy(&length, _data + at, sizeof(length));
+        if (length == ~std::uint32_t(0)) {
+          ok = capacity - at < available;
+          h += capacity - at;
+          available -= capacity - at;
+          at = 0;
+          if (ok) { std::memcpy(&length, _data, sizeof(length)); }
+        }
+      }
+      if (!ok || length > max_payload() || _padded(length) > available ||
+          _padded(length) > capacity - at) {
+        n = 0;
+        _read = t;
+        return _data;
+      }
+      n = length;
+      _read = h + _padded(length);
+      return _data + at + 8;
+    }
+
+    // Waits for the next message
+    const unsigned char * read(std::size_t & n)
+    {
+      const unsigned char * p = nullptr;
+      _wait([&] { return (p = try_read(n)) != nullptr; });
+      return p;
+    }
+
+    void end_read() { _state->head.store(_read, std::memory_order_release); }
+
+    private:
+    static std::uint64_t _padded(std::size_t n) { return (8 + n + 7) & ~std::uint64_t(7); }
+
+    // Spins briefly, then yields to the other process
+    template <typename Ready>
+    static void _wait(Ready ready)
+    {
+      for (int spins = 0; !ready(); spins++) {
+        if (spins > 64) { std::this_thread::yield(); }
+      }
+    }
+
+    ipc_ring_state * _state;
+    unsigned char * _data;
+    std::uint64_t _mask;
+    std::uint64_t _read;
+    std::uint64_t _write;
+  };
+
+  // A named shared memory region holding a request ring, a response ring
+  // and a scratch area for zero copy buffers. One side creates it, the
+  // other opens it by name.
+  class ipc_channel
+  {
+    public:
+    ipc_channel() : _base(nullptr), _bytes(0), _owner(false), _scratch_used(0) {}
+
+    ~ipc_channel() { close(); }
+
+    ipc_channel(const ipc_channel &) = delete;
+    ipc_channel & operator=(const ipc_channel &) = delete;
+
+    // Creates the region, ring_bytes is rounded up to a power of two.
+    // Returns false if the name is taken or the region can't be mapped.
+    bool create(const char * name, std::size_t ring_bytes = 1 << 16,
+                std::size_t scratch_bytes = 1 << 20)
+    {
+      std::size_t rings = 64;
+      while (rings < ring_bytes) { rings *= 2; }
+      std::size_t bytes = sizeof(shared) + 2 * rings + scratch_bytes;
+
+      int fd = ::shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+      if (fd < 0) { return false; }
+      if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0 || !_map(fd, bytes)) {
+        ::close(fd);
+        ::shm_unlink(name);
+        return false;
+      }
+      ::close(fd);
+
+      shared * s = new (_base) shared();
+      s->ring_bytes = rings;
+      s->scratch_bytes = scratch_bytes;
+      s->request.head.store(0);
+      s->request.tail.store(0);
+      s->response.head.store(0);
+      s->response.tail.store(0);
+      std::strncpy(_name, name, sizeof(_name) - 1);
+      _name[sizeof(_name) - 1] = 0;
+      _owner = true;
+      _attach(s);
+      s->magic.store(magic, std::memory_order_release);
+      return true;
+    }
+
+    // Opens a region made by create. Returns false if it doesn't exist, or
+    // its header doesn't describe rings and a scratch area that fit in it.
+    bool open(const char * name)
+    {
+      int fd = ::shm_open(name, O_RDWR, 0600);
+      if (fd < 0) { return false; }
+      struct stat st;
+      bool ok = ::fstat(fd, &st) == 0 &&
+                static_cast<std::size_t>(st.st_size) >= sizeof(shared) &&
+                _map(fd, static_cast<std::size_t>(st.st_size));
+      ::close(fd);
+      if (!ok) { return false; }
+      shared * s = static_cast<shared *>(_base);
+      if (s->magic.load(std::memory_order_acquire) != magic || !_attach(s)) {
+        close();
+        return false;
+      }
+      return true;
+    }
+
+    void close()
+    {
+      if (!_base) { return; }
+      ::munmap(_base, _bytes);
+      if (_owner) { ::shm_unlink(_name); }
+      _base = nullptr;
+      _owner = false;
+    }
+
+    explicit operator bool() const { return _base != nullptr; }
+
+    // Client side allocation in the scratch area, nullptr when full.
+    // Buffers passed as ipc_span from here are not copied. The scratch
+    // area belongs to the client, the server only reads it.
+    void * scratch(std::size_t n)
+    {
+      n = (n + 15) & ~std::size_t(15);
+      if (_scratch_used + n > _scratch_bytes) { return nullptr; }
+      void * p = _scratch + _scratch_used;
+      _scratch_used += n;
+      return p;
+    }
+
+    void reset_scratch() { _scratch_used = 0; }
+
+    ipc_ring & requests() { return _requests; }
+    ipc_ring & responses() { return _responses; }
+
+    bool in_scratch(const void * p, std::size_t n) const
+    {
+      const unsigned char * c = static_cast<const unsigned char *>(p);
+      return c >= _scratch && c + n <= _scratch + _scratch_bytes;
+    }
+
+    std::uint64_t scratch_offset(const void * p) const
+    {
+      return static_cast<std::uint64_t>(static_cast<const unsigned char *>(p) - _scratch);
+    }
+
+    const void * scratch_at(std::uint64_t offset) const { return _scratch + offset; }
+
+    std::size_t scratch_size() const { return _scratch_bytes; }
+
+    private:
+    static const std::uint64_t magic = 0x61726368495043ull;
+
+    struct shared
+    {
+      std::atomic<std::uint64_t> magic;
+      std::uint64_t ring_bytes;
+      std::uint64_t scratch_bytes;
+      ipc_ring_state request;
+      ipc_ring_state response;
+    };
+
+    bool _map(int fd, std::size_t bytes)
+    {
+      void * p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if (p == MAP_FAILED) { return false; }
+      _base = p;
+      _bytes = bytes;
+      return true;
+    }
+
+    // The header is written by the other process, so the sizes are checked
+    // against the mapping before they are used
+    bool _attach(shared * s)
+    {
+      const std::uint64_t space = _bytes - sizeof(shared);
+      const std::uint64_t rings = s->ring_bytes;
+      if (rings < 64 || (rings & (rings - 1)) != 0 || rings > space / 2 ||
+          s->scratch_bytes > space - 2 * rings) {
+        return false;
+      }
+      unsigned char * data = static_cast<unsigned char *>(_base) + sizeof(shared);
+      _requests = ipc_ring(&s->request, data, rings);
+      _responses = ipc_ring(&s->response, data + rings, rings);
+      _scratch = data + 2 * rings;
+      _scratch_bytes = static_cast<std::size_t>(s->scratch_bytes);
+      _scratch_used = 0;
+      return true;
+    }
+
+    void * _base;
+    std::size_t _bytes;
+    bool _owner;
+    char _name[256];
+    ipc_ring _requests;
+    ipc_ring _responses;
+    unsigned char * _scratch;
+    std::size_t _scratch_bytes;
+    std::size_t _scratch_used;
+  };
+
+  // Encoding of argument and result types. Trivially copyable values are
+  // copied, pointers other than const char * and ipc_span are rejected.
+  // decode reads from p up to end, the end of the request, and returns
+  // false for bytes that don't encode a value, as sent by a faulty peer.
+  template <typename T>
+  struct ipc_codec
+  {
+    static_assert(std::is_trivially_copyable<T>::value && !std::is_pointer<T>::value,
+                  "ipc arguments must be trivially copyable values, const char * "
+                  "or archetype::ipc_span");
+
+    static std::size_t size(const T &, const ipc_channel &) { return sizeof(T); }
+
+    static unsigned char * encode(unsigned char * p, const T & t, const ipc_channel &)
+    {
+      std::memcpy(p, &t, sizeof(T));
+      return p + sizeof(T);
+    }
+
+    static bool decode(const unsigned char *& p, const unsigned char * end, T & t,
+                       const ipc_channel &)
+    {
+      if (static_cast<std::size_t>(end - p) < sizeof(T)) { return false; }
+      std::memcpy(&t, p, sizeof(T));
+      p += sizeof(T);
+      return true;
+    }
+  };
+
+  // Strings are copied into the request once, the server reads them in place
+  template <>
+  struct ipc_codec<const char *>
+  {
+    static std::size_t size(const char * s, const ipc_channel &)
+    {
+      return sizeof(std::uint32_t) + std::strlen(s) + 1;
+    }
+
+    static unsigned char * encode(unsigned char * p, const char * s, const ipc_channel &)
+    {
+      std::uint32_t n = static_cast<std::uint32_t>(std::strlen(s) + 1);
+      std::memcpy(p, &n, sizeof(n));
+      std::memcpy(p + sizeof(n), s, n);
+      return p + sizeof(n) + n;
+    }
+
+    // The string must lie in the request, terminator included
+    static bool decode(const unsigned char *& p, const unsigned char * end,
+                       const char *& s, const ipc_channel &)
+    {
+      std::uint32_t n;
+      if (static_cast<std::size_t>(end - p) < sizeof(n)) { return false; }
+      std::memcpy(&n, p, sizeof(n));
+      p += sizeof(n);
+      if (n == 0 || n > static_cast<std::size_t>(end - p) || p[n - 1] != 0) { return false; }
+      s = reinterpret_cast<const char *>(p);
+      p += n;
+      return true;
+    }
+  };
+
+  template <>
+  struct ipc_codec<ipc_span>
+  {
+    static std::size_t size(const ipc_span & b, const ipc_channel & c)
+    {
+      return 1 + 2 * sizeof(std::uint64_t) + (c.in_scratch(b.data, b.size) ? 0 : b.size);
+    }
+
+    static unsigned char * encode(unsigned char * p, const ipc_span & b,
+                                  const ipc_channel & c)
+    {
+      std::uint64_t size = b.size;
+      bool shared = c.in_scratch(b.data, b.size);
+      std::uint64_t offset = shared ? c.scratch_offset(b.data) : 0;
+      *p = shared ? 1 : 0;
+      std::memcpy(p + 1, &offset, sizeof(offset));
+      std::memcpy(p + 1 + sizeof(offset), &size, sizeof(size));
+      p += 1 + 2 * sizeof(std::uint64_t);
+      if (shared) { return p; }
+      if (b.size) { std::memcpy(p, b.data, b.size); }
+      return p + b.size;
+    }
+
+    // Shared buffers must lie in the scratch area, copied ones in the request
+    static bool decode(const unsigned char *& p, const unsigned char * end, ipc_span & b,
+                       const ipc_channel & c)
+    {
+      if (static_cast<std::size_t>(end - p) < 1 + 2 * sizeof(std::uint64_t)) { return false; }
+      bool shared = *p != 0;
+      std::uint64_t offset, size;
+      std::memcpy(&offset, p + 1, sizeof(offset));
+      std::memcpy(&size, p + 1 + sizeof(offset), sizeof(size));
+      p += 1 + 2 * sizeof(std::uint64_t);
+      if (shared) {
+        if (offset > c.scratch_size() || size > c.scratch_size() - offset) { return false; }
+        b.data = c.scratch_at(offset);
+      } else {
+        if (size > static_cast<std::uint64_t>(end - p)) { return false; }
+        b.data = p;
+        p += size;
+      }
+      b.size = static_cast<std::size_t>(size);
+      return true;
+    }
+  };
+
+  // Writes the response to a call, the bytes of the result if any
+  template <typename R>
+  struct ipc_respond
+  {
+    // A result too large for the ring is answered with an empty response
+    template <typename F>
+    static void call(ipc_channel & c, F f)
+    {
+      R r = f();
+      if (unsigned char * p = c.responses().begin_write(sizeof(R))) {
+        std::memcpy(p, &r, sizeof(R));
+      } else {
+        c.responses().begin_write(0);
+      }
+      c.responses().commit_write();
+    }
+
+    // The result, or the null result for an empty response, which is
+    // counted in failed
+    static R read(ipc_channel & c, std::size_t & failed)
+    {
+      std::size_t n;
+      const unsigned char * p = c.responses().read(n);
+      R r = null_result<R>::get();
+      if (n == sizeof(R)) {
+        std::memcpy(&r, p, sizeof(R));
+      } else {
+        failed++;
+      }
+      c.responses().end_read();
+      return r;
+    }
+  };
+
+  template <>
+  struct ipc_respond<void>
+  {
+    template <typename F>
+    static void call(ipc_channel & c, F f)
+    {
+      f();
+      c.responses().begin_write(0);
+      c.responses().commit_write();
+    }
+
+    static void read(ipc_channel & c, std::size_t &)
+    {
+      std::size_t n;
+      c.responses().read(n);
+      c.responses().end_read();
+    }
+  };
+
+  template <class Archetype, typename Methods = typename helper<Archetype>::methods>
+  class ipc_client_base;
+
+  template <class Archetype, typename... Ms>
+  class ipc_client_base<Archetype, type_list<Ms...>>
+  {
+    public:
+    template <typename R>
+    struct result
+    {
+      static_assert(std::is_void<R>::value ||
+                        (std::is_trivially_copyable<R>::value &&
+                         !std::is_pointer<R>::value && !std::is_reference<R>::value),
+                    "ipc results must be void or trivially copyable values");
+      using type = R;
+    };
+
+    explicit operator bool() const { return _channel && *_channel; }
+
+    // Calls that failed because the request or the result didn't fit in
+    // the ring, or the server didn't recognise the method. They return the
+    // null result.
+    std::size_t failed() const { return _failed; }
+
+    protected:
+    // Sends the call, then waits for the server to answer it
+    template <typename R, typename Method, typename... Args>
+    R _forward(Args... args)
+    {
+      const std::uint32_t id = static_cast<std::uint32_t>(index_of<Method, Ms...>::value);
+      std::size_t sizes[] = {sizeof(id), ipc_codec<Args>::size(args, *_channel)...};
+      std::size_t n = 0;
+      for (std::size_t s : sizes) { n += s; }
+
+      unsigned char * p = _channel->requests().begin_write(n);
+      if (!p) {
+        _failed++;
+        return null_result<R>::get();
+      }
+      std::memcpy(p, &id, sizeof(id));
+      p += sizeof(id);
+      unsigned char * expand[] = {p, (p = ipc_codec<Args>::encode(p, args, *_channel))...};
+      (void)expand;
+      _channel->requests().commit_write();
+
+      return ipc_respond<R>::read(*_channel, _failed);
+    }
+
+    ipc_channel * _channel;
+    std::size_t _failed;
+  };
+
+  // Proxy with the methods of Archetype that runs each call in the process
+  // serving the channel, and waits for its result. One proxy per channel.
+  template <class Archetype>
+  class ipc_client
+      : public helper<Archetype>::template forward_layer<ipc_client_base<Archetype>>
+  {
+    public:
+    explicit ipc_client(ipc_channel & channel)
+    {
+      this->_channel = &channel;
+      this->_failed = 0;
+    }
+  };
+
+  template <class Archetype, typename Methods = typename helper<Archetype>::methods>
+  class ipc_server;
+
+  // Decodes calls from a channel and makes them on a bound view
+  template <class Archetype, typename... Ms>
+  class ipc_server<Archetype, type_list<Ms...>>
+  {
+    using view = typename Archetype::view;
+
+    public:
+    ipc_server(ipc_channel & channel, view target)
+        : _channel(&channel), _target(target) {}
+
+    // Serves one call if there is one waiting
+    bool poll()
+    {
+      std::size_t n;
+      const unsigned char * p = _channel->requests().try_read(n);
+      if (!p) { return false; }
+      _serve(p, n);
+      return true;
+    }
+
+    // Waits for and serves one call
+    void serve_one()
+    {
+      std::size_t n;
+      const unsigned char * p = _channel->requests().read(n);
+      _serve(p, n);
+    }
+
+    private:
+    using thunk = void (*)(ipc_server &, const unsigned char *, const unsigned char *);
+
+    void _serve(const unsigned char * p, std::size_t n)
+    {
+      static const thunk thunks[] = {&_call<Ms, typename Ms::_signature>::serve...};
+      std::uint32_t id = sizeof...(Ms);
+      if (n >= sizeof(id)) { std::memcpy(&id, p, sizeof(id)); }
+      if (id >= sizeof...(Ms)) {
+        _reject();
+        return;
+      }
+      thunks[id](*this, p + sizeof(id), p + n);
+    }
+
+    // Answers a request without a valid method id or arguments with an
+    // empty response, which the client counts in failed
+    void _reject()
+    {
+      _channel->requests().end_read();
+      _channel->responses().begin_write(0);
+      _channel->responses().commit_write();
+    }
+
+    template <typename Method, typename Signature> struct _call;
+
+    template <typename Method, typename R, typename... Args>
+    struct _call<Method, R(Args...)>
+    {
+      using values = std::tuple<typename std::decay<Args>::type...>;
+
+      static void serve(ipc_server & s, const unsigned char * p, const unsigned char * end)
+      {
+        values args;
+        if (!_decode(s, p, end, args, typename make_indices<sizeof...(Args)>::type())) {
+          s._reject();
+          return;
+        }
+        _apply(s, args, typename make_indices<sizeof...(Args)>::type());
+        // strings and copied buffers point into the request until here
+        s._channel->requests().end_read();
+      }
+
+      // Decodes the arguments in order, stopping at the first bad one
+      template <std::size_t... Is>
+      static bool _decode(ipc_server & s, const unsigned char *& p, const unsigned char * end,
+                          values & args, indices<Is...>)
+      {
+        (void)s;
+        (void)p;
+        (void)end;
+        (void)args;
+        bool ok = true;
+        // braced initialisation evaluates in order
+        bool decoded[] = {true, (ok = ok && ipc_codec<typename std::decay<Args>::type>::decode(
+                                               p, end, std::get<Is>(args), *s._channel))...};
+        (void)decoded;
+        return ok;
+      }
+
+      template <std::size_t... Is>
+      static void _apply(ipc_server & s, values & args, indices<Is...>)
+      {
+        (void)args;
+        ipc_respond<R>::call(*s._channel, [&]() -> R {
+          return Method::template _call<view>(&s._target, std::get<Is>(args)...);
+        });
+      }
+    };
+
+    ipc_channel * _channel;
+    view _target;
+  };
+
+} // namespace archetype
+
+#endif //__ARCHETYPE_IPC_H__
@@ -0,0 +1,853 @@
+#ifndef __ARCHETYPE_MACROS_H__
+#define __ARCHETYPE_MACROS_H__
+
+// The macro API of archetype, included by archetype.h. Code importing the
+// archetype module includes only this, expansions need the standard
+// headers below.
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+//-- API
+#define ARCHETYPE_METHOD(ret, name, ...)                                       \
+  (METHOD, ARCH_PP_UNIQUE_NAME(name), ret, name, __VA_ARGS__)
+
+// A method whose result depends only on the object and the arguments, and
+// that changes nothing. It is bound and called like any other method, a
+// memo_cache remembers its results.
+#define ARCHETYPE_PURE_METHOD(ret, name, ...)                                  \
+  (PURE, ARCH_PP_UNIQUE_NAME(name), ret, name, __VA_ARGS__)
+
+// An operator method, op is the operator's symbol, e.g. (), [], < or ==.
+// Member operators may be const, and operator views are callable on const
+// views, so views can be used as comparators and hashers.
+#define ARCHETYPE_OPERATOR(ret, op, ...)                                       \
+  (OPERATOR, ARCH_PP_UNIQUE_NAME(operator), ret, op, __VA_ARGS__)
+
+// A data member read through the view as type & name(). The vtable holds
+// the member's offset rather than a function pointer.
+#define ARCHETYPE_FIELD(type, name)                                            \
+  (FIELD, ARCH_PP_UNIQUE_NAME(name), type, name)
+
+#define ARCHETYPE_CHECK(ARCHETYPE, TYPE)\
+  static_assert(ARCHETYPE::check<TYPE>::value, STRINGIFY(TYPE must satisfy ARCHETYPE::check));
+
+// Keeps the binding of TYPE to ARCHETYPE out of the TUs that see this,
+// usually next to TYPE in its header. Views bound to TYPE there call into
+// the one TU with ARCHETYPE_INSTANTIATE_BINDING rather than each
+// instantiating the vtable and stubs. Both name archetype::bound_vtable, so
+// they must be used at global scope, with qualified names for ARCHETYPE and
+// TYPE.
+#define ARCHETYPE_EXTERN_BINDING(ARCHETYPE, TYPE)                              \
+  extern template struct archetype::bound_vtable<ARCHETYPE, TYPE>;
+
+#define ARCHETYPE_INSTANTIATE_BINDING(ARCHETYPE, TYPE)                         \
+  ARCHETYPE_CHECK(ARCHETYPE, TYPE)                                             \
+  template struct archetype::bound_vtable<ARCHETYPE, TYPE>;
+
+#define ARCHETYPE_DEFINE(NAME, METHODS)                                        \
+  struct NAME {                                                                \
+    NAME() = delete;                                                           \
+    ~NAME() = delete;                                                          \
+    NAME & operator=(const NAME &) = delete;                                   \
+                                                                               \
+    friend struct archetype::helper<NAME>;                                      \
+                                                                               \
+    /* Per method member and free function detection, and call selection */   \
+    protected:                                                                 \
+    ARCH_PP_EXPAND_METHOD_CALLERS(METHODS)                                     \
+                                                                               \
+    using _methods = archetype::type_list<ARCH_PP_EXPAND_METHOD_TYPES(METHODS)>;\
+                                                                               \
+    /* SFINAE based type checking against requirements */                      \
+    public:                                                                    \
+    template <typename T>                                                      \
+    struct check                                                               \
+        : std::integral_constant<bool,                                         \
+                                 true ARCH_PP_EXPAND_REQUIREMENTS(METHODS)> {};\
+                                                                               \
+    /* Internal protected vtable, and view_layer implementation */             \
+    protected:                                                                 \
+    template <typename BaseVTable = archetype::vtable_base>                    \
+    struct vtable : public BaseVTable                                          \
+    {                                                                          \
+      ARCH_PP_EXPAND_CALLSTUB_MEMBERS(METHODS)                                 \
+                                                                               \
+      template<typename T>                                                     \
+      void bind()                                                              \
+      {                                                                        \
+        ARCHETYPE_CHECK(NAME, T)                                               \
+        this->BaseVTable::template bind<T>();                                  \
+        ARCH_PP_EXPAND_CALLSTUB_ASSIGNMENTS(METHODS)                           \
+      }                                                                        \
+                                                                               \
+      void bind_null()                                                         \
+      {                                                                        \
+        this->BaseVTable::bind_null();                                         \
+        ARCH_PP_EXPAND_NULLSTUB_ASSIGNMENTS(METHODS)                           \
+      }                                                                        \
+                                                                               \
+      ARCH_PP_MAKE_VTABLE_FUNCTIONS                                            \
+    };                                                                         \
+                                                                               \
+    /* vtable whose stubs forward to a dispatch policy */                      \
+    template <typename BaseDispatch>                                           \
+    struct dispatch_vtable : public BaseDispatch                               \
+    {                                                                          \
+      ARCH_PP_EXPAND_DISPATCH_STUBS(METHODS)                                   \
+    };                                                                         \
+                                                                               \
+    /* methods forwarded to BaseForward, which also picks the return type */   \
+    template <typename BaseForward>                                            \
+    struct forward_layer : public BaseForward                                  \
+    {                                                                          \
+      ARCH_PP_EXPAND_FORWARD_METHODS(METHODS)                                  \
+    };                                                                         \
+                                                                               \
+    template<typename BaseViewLayer = archetype::view_base<vtable<>>>          \
+    struct view_layer : public BaseViewLayer                                   \
+    {                                                                          \
+      ARCH_PP_EXPAND_METHODS(METHODS)                                          \
+                                                                               \
+      protected:                                                               \
+      using BaseViewLayer::_obj;                                               \
+      using BaseViewLayer::_vtbl;                                              \
+    };                                                                         \
+                                                                               \
+    /* Public view, and ptr structures */                                      \
+    public:                                                                    \
+    ARCH_PP_COMMON_BLOCK(NAME)                                                 \
+  };
+
+
+#define ARCHETYPE_COMPOSE(NAME, ...)                                           \
+  struct NAME {                                                                \
+    NAME() = delete;                                                           \
+    ~NAME() = delete;                                                          \
+    NAME & operator=(const NAME &) = delete;                                   \
+                                                                               \
+    friend struct archetype::helper<NAME>;                                      \
+                                                                               \
+    /* SFINAE based type checking against requirements */                      \
+    template <typename T>                                                      \
+    struct check                                                               \
+        : std::integral_constant<bool, ARCH_PP_EXPAND_COMPONENT_REQUIREMENTS(  \
+                                           __VA_ARGS__)> {};                   \
+                                                                               \
+    protected:                                                                 \
+    using _methods = typename archetype::concat_unique<                        \
+        archetype::type_list<>, ARCH_PP_FOR_EACH_SEP_CALL(                     \
+                                    ARCH_PP_APPLY_METHODS_HELPER, __VA_ARGS__)>::type;\
+                                                                               \
+    protected:                                                                 \
+    template<typename BaseVTable = archetype::vtable_base>                     \
+    struct vtable : public ARCH_PP_EXPAND_VTABLE_INHERITANCE(__VA_ARGS__)      \
+    {                                                                          \
+      using this_base = ARCH_PP_EXPAND_VTABLE_INHERITANCE(__VA_ARGS__);        \
+      template<typename T>                                                     \
+      void bind()                                                              \
+      {                                                                        \
+        this->this_base::template bind<T>();                                   \
+      }                                                                        \
+                                                                               \
+      void bind_null()                                                         \
+      {                                                                        \
+        this->this_base::bind_null();                                          \
+      }                                                                        \
+                                                                               \
+      ARCH_PP_MAKE_VTABLE_FUNCTIONS                                            \
+    };                                                                         \
+                                                                               \
+    template <typename BaseDispatch>                                           \
+    struct dispatch_vtable                                                     \
+        : public ARCH_PP_EXPAND_DISPATCH_INHERITANCE(__VA_ARGS__) {};          \
+                                                                               \
+    template <typename BaseForward>                                            \
+    struct forward_layer                                                       \
+        : public ARCH_PP_EXPAND_FORWARD_INHERITANCE(__VA_ARGS__) {};           \
+                                                                               \
+    template<typename BaseViewLayer = archetype::view_base<vtable<>>>          \
+    struct view_layer: public ARCH_PP_EXPAND_VIEW_LAYER_INHERITANCE(__VA_ARGS__)\
+    {                                                                          \
+      protected:                                                               \
+      using BaseViewLayer::_obj;                                               \
+      using BaseViewLayer::_vtbl;                                              \
+    };                                                                         \
+                                                                               \
+    /* Public view, and ptr structures */                                      \
+    public:                                                                    \
+    ARCH_PP_COMMON_BLOCK(NAME)                                                 \
+  };
+
+//-- High level internal expansions
+#define ARCH_PP_COMMON_BLOCK(NAME)                                             \
+  struct view : public view_layer<>                                            \
+  {                                                                            \
+    view()                                                                     \
+    {                                                                          \
+      this->_obj = nullptr;                                                    \
+      this->_vtbl = vtable<>::make_null_vtable();                              \
+    }                                                                          \
+                                                                               \
+    template<typename T, typename = typename std::enable_if<                   \
+                           !std::is_base_of<view, T>::value>::type>            \
+    view(T & t)                                                                \
+    {                                                                          \
+      this->_obj = static_cast<void *>(&t);                                    \
+      this->_vtbl = archetype::bound_vtable<NAME, T>::get();                   \
+    }                                                                          \
+  };                                                                           \
+                                                                               \
+  template <template <typename> class API = archetype::identity>         \
+  struct ptr                                                                   \
+  {                                                                            \
+    ptr() {}                                                                   \
+                                                                               \
+    template<typename T>                                                       \
+    ptr(T & t) : _view(t) {}                                                   \
+                                                                               \
+    API<view> &operator*() { return _view; }                                   \
+    const API<view> &operator*() const { return _view; }                       \
+    API<view> *operator->() { return &_view; }                                 \
+    const API<view> *operator->() const { return &_view; }                     \
+                                                                               \
+    protected:                                                                 \
+    API<view> _view;                                                           \
+  };
+
+// vtables are bound once per type, the null vtable is shared by every
+// default constructed view
+#define ARCH_PP_MAKE_VTABLE_FUNCTIONS                                          \
+  template<typename T>                                                         \
+  static const vtable * make_vtable()                                          \
+  {                                                                            \
+    static vtable<BaseVTable> vtablet;                                         \
+    static const bool bound =                                                  \
+        (vtablet.bind<T>(),                                                    \
+         vtablet._index = archetype::next_vtable_index<vtable>(), true);       \
+    (void)bound;                                                               \
+    return &vtablet;                                                           \
+  }                                                                            \
+                                                                               \
+  static const vtable * make_null_vtable()                                     \
+  {                                                                            \
+    static vtable<BaseVTable> vtablet;                                         \
+    static const bool bound = (vtablet.bind_null(), true);                     \
+    (void)bound;                                                               \
+    return &vtablet;                                                           \
+  }
+
+#define ARCH_PP_EXPAND_METHODS(METHODS) ARCH_PP_EXPAND_METHODS_IMPL METHODS
+
+#define ARCH_PP_EXPAND_METHODS_IMPL(...)                                       \
+  ARCH_PP_FOR_EACH(ARCH_PP_METHOD, __VA_ARGS__)
+
+#define ARCH_PP_EXPAND_CALLSTUB_ASSIGNMENTS(METHODS)                           \
+  ARCH_PP_EXPAND_CALLSTUB_ASSIGNMENTS_IMPL METHODS
+
+#define ARCH_PP_EXPAND_CALLSTUB_ASSIGNMENTS_IMPL(...)                          \
+  ARCH_PP_FOR_EACH(ARCH_PP_CALLSTUB_ASSIGNMENT, __VA_ARGS__)
+
+#define ARCH_PP_EXPAND_NULLSTUB_ASSIGNMENTS(METHODS)                           \
+  ARCH_PP_EXPAND_NULLSTUB_ASSIGNMENTS_IMPL METHODS
+
+#define ARCH_PP_EXPAND_NULLSTUB_ASSIGNMENTS_IMPL(...)                          \
+  ARCH_PP_FOR_EACH(ARCH_PP_NULLSTUB_ASSIGNMENT, __VA_ARGS__)
+
+#define ARCH_PP_EXPAND_DISPATCH_STUBS(METHODS)                                 \
+  ARCH_PP_EXPAND_DISPATCH_STUBS_IMPL METHODS
+
+#define ARCH_PP_EXPAND_DISPATCH_STUBS_IMPL(...)                                \
+  ARCH_PP_FOR_EACH(ARCH_PP_DISPATCH_STUB, __VA_ARGS__)
+
+#define ARCH_PP_EXPAND_FORWARD_METHODS(METHODS)                                \
+  ARCH_PP_EXPAND_FORWARD_METHODS_IMPL METHODS
+
+#define ARCH_PP_EXPAND_FORWARD_METHODS_IMPL(...)                               \
+  ARCH_PP_FOR_EACH(ARCH_PP_FORWARD_METHOD, __VA_ARGS__)
+
+#define ARCH_PP_EXPAND_METHOD_TYPES(METHODS)                                   \
+  ARCH_PP_EXPAND_METHOD_TYPES_IMPL METHODS
+
+#define ARCH_PP_EXPAND_METHOD_TYPES_IMPL(...)                                  \
+  ARCH_PP_FOR_EACH_SEP(ARCH_PP_METHOD_TYPE, __VA_ARGS__)
+
+#define ARCH_PP_EXPAND_CALLSTUB_MEMBERS(METHODS)                               \
+  ARCH_PP_EXPAND_CALLSTUB_MEMBERS_IMPL METHODS
+
+#define ARCH_PP_EXPAND_CALLSTUB_MEMBERS_IMPL(...)                              \
+  ARCH_PP_FOR_EACH(ARCH_PP_CALLSTUB_MEMBER, __VA_ARGS__)
+
+#define ARCH_PP_EXPAND_REQUIREMENTS(METHODS)                                   \
+  ARCH_PP_EXPAND_REQUIREMENTS_IMPL METHODS
+
+#define ARCH_PP_EXPAND_REQUIREMENTS_IMPL(...)                                  \
+  ARCH_PP_FOR_EACH(ARCH_PP_REQUIREMENT, __VA_ARGS__)
+
+#define ARCH_PP_EXPAND_METHOD_CALLERS(METHODS)                                 \
+  ARCH_PP_EXPAND_METHOD_CALLERS_IMPL METHODS
+
+#define ARCH_PP_EXPAND_METHOD_CALLERS_IMPL(...)                                \
+  ARCH_PP_FOR_EACH(ARCH_PP_METHOD_CALLER, __VA_ARGS__)
+
+#define ARCH_PP_EXPAND_VTABLE_INHERITANCE(...)                              \
+  ARCH_PP_EXPAND_VTABLE_INHERITANCE_IMPL(                                   \
+      ARCH_PP_FOR_EACH_SEP_CALL(ARCH_PP_APPLY_VTABLE_HELPER, __VA_ARGS__))
+
+#define ARCH_PP_EXPAND_VTABLE_INHERITANCE_IMPL(...)                         \
+  ARCH_PP_TEMPLATE_CHAIN(__VA_ARGS__ ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__) BaseVTable)
+
+#define ARCH_PP_EXPAND_DISPATCH_INHERITANCE(...)                               \
+  ARCH_PP_EXPAND_DISPATCH_INHERITANCE_IMPL(                                    \
+      ARCH_PP_FOR_EACH_SEP_CALL(ARCH_PP_APPLY_DISPATCH_HELPER, __VA_ARGS__))
+
+#define ARCH_PP_EXPAND_DISPATCH_INHERITANCE_IMPL(...)                          \
+  ARCH_PP_TEMPLATE_CHAIN(__VA_ARGS__ ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__) BaseDispatch)
+
+#define ARCH_PP_EXPAND_FORWARD_INHERITANCE(...)                                \
+  ARCH_PP_EXPAND_FORWARD_INHERITANCE_IMPL(                                     \
+      ARCH_PP_FOR_EACH_SEP_CALL(ARCH_PP_APPLY_FORWARD_HELPER, __VA_ARGS__))
+
+#define ARCH_PP_EXPAND_FORWARD_INHERITANCE_IMPL(...)                           \
+  ARCH_PP_TEMPLATE_CHAIN(__VA_ARGS__ ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__) BaseForward)
+
+#define ARCH_PP_EXPAND_VIEW_LAYER_INHERITANCE(...)                              \
+  ARCH_PP_EXPAND_VIEW_LAYER_INHERITANCE_IMPL(                                   \
+      ARCH_PP_FOR_EACH_SEP_CALL(ARCH_PP_APPLY_VIEW_LAYER_HELPER, __VA_ARGS__))
+
+#define ARCH_PP_EXPAND_VIEW_LAYER_INHERITANCE_IMPL(...)                         \
+  ARCH_PP_TEMPLATE_CHAIN(__VA_ARGS__ ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__) BaseViewLayer)
+
+#define ARCH_PP_EXPAND_COMPONENT_REQUIREMENTS(...)                             \
+  ARCH_PP_FOR_EACH_SEPX_CALL(ARCH_PP_APPEND_CHECK, &&, __VA_ARGS__)
+
+//-- Low level internal expressions
+// Each entry is (KIND, unique name, type, name, args...), KIND selects the
+// METHOD, PURE, OPERATOR or FIELD form of every expansion
+#define ARCH_PP_METHOD(KIND, ...) ARCH_PP_METHOD_##KIND(__VA_ARGS__)
+#define ARCH_PP_CALLSTUB_ASSIGNMENT(KIND, ...)                                 \
+  ARCH_PP_CALLSTUB_ASSIGNMENT_##KIND(__VA_ARGS__)
+#define ARCH_PP_METHOD_CALLER(KIND, ...) ARCH_PP_METHOD_CALLER_##KIND(__VA_ARGS__)
+#define ARCH_PP_METHOD_TYPE(KIND, ...) ARCH_PP_METHOD_TYPE_METHOD(__VA_ARGS__)
+#define ARCH_PP_NULLSTUB_ASSIGNMENT(KIND, ...)                                 \
+  ARCH_PP_NULLSTUB_ASSIGNMENT_##KIND(__VA_ARGS__)
+#define ARCH_PP_DISPATCH_STUB(KIND, ...) ARCH_PP_DISPATCH_STUB_##KIND(__VA_ARGS__)
+#define ARCH_PP_FORWARD_METHOD(KIND, ...) ARCH_PP_FORWARD_METHOD_##KIND(__VA_ARGS__)
+#define ARCH_PP_CALLSTUB_MEMBER(KIND, ...)                                     \
+  ARCH_PP_CALLSTUB_MEMBER_##KIND(__VA_ARGS__)
+#define ARCH_PP_REQUIREMENT(KIND, ...) ARCH_PP_REQUIREMENT_##KIND(__VA_ARGS__)
+
+// Pure methods are methods whose description says they are pure
+#define ARCH_PP_METHOD_PURE ARCH_PP_METHOD_METHOD
+#define ARCH_PP_CALLSTUB_ASSIGNMENT_PURE ARCH_PP_CALLSTUB_ASSIGNMENT_METHOD
+#define ARCH_PP_NULLSTUB_ASSIGNMENT_PURE ARCH_PP_NULLSTUB_ASSIGNMENT_METHOD
+#define ARCH_PP_DISPATCH_STUB_PURE ARCH_PP_DISPATCH_STUB_METHOD
+#define ARCH_PP_FORWARD_METHOD_PURE ARCH_PP_FORWARD_METHOD_METHOD
+#define ARCH_PP_CALLSTUB_MEMBER_PURE ARCH_PP_CALLSTUB_MEMBER_METHOD
+#define ARCH_PP_REQUIREMENT_PURE ARCH_PP_REQUIREMENT_METHOD
+
+#define ARCH_PP_METHOD_CALLER_PURE(ARCH_PP_UNIQUE_NAME, ret, name, ...)         \
+  ARCH_PP_METHOD_CALLER_IMPL(using _pure = std::true_type;,                    \
+                             ARCH_PP_UNIQUE_NAME, ret, name, __VA_ARGS__)
+
+// Operators share every expansion that doesn't spell the name
+#define ARCH_PP_CALLSTUB_ASSIGNMENT_OPERATOR ARCH_PP_CALLSTUB_ASSIGNMENT_METHOD
+#define ARCH_PP_NULLSTUB_ASSIGNMENT_OPERATOR ARCH_PP_NULLSTUB_ASSIGNMENT_METHOD
+#define ARCH_PP_DISPATCH_STUB_OPERATOR ARCH_PP_DISPATCH_STUB_METHOD
+#define ARCH_PP_CALLSTUB_MEMBER_OPERATOR ARCH_PP_CALLSTUB_MEMBER_METHOD
+
+#define ARCH_PP_METHOD_OPERATOR(ARCH_PP_UNIQUE_NAME, ret, op, ...)             \
+public:                                                                        \
+  ret operator op(TYPED_ARGS(M_NARGS(__VA_ARGS__), __VA_ARGS__)) const {       \
+    return _vtbl->_##ARCH_PP_UNIQUE_NAME##_stub(_obj ARCH_PP_COMMA_IF_ARGS(    \
+        __VA_ARGS__) ARCH_PP_ARG_NAMES(M_NARGS(__VA_ARGS__), __VA_ARGS__));    \
+  }
+
+#define ARCH_PP_FORWARD_METHOD_OPERATOR(ARCH_PP_UNIQUE_NAME, ret, op, ...)     \
+public:                                                                        \
+  typename BaseForward::template result<ret>::type operator op(                \
+      TYPED_ARGS(M_NARGS(__VA_ARGS__), __VA_ARGS__)) {                         \
+    return this->template _forward<ret, _##ARCH_PP_UNIQUE_NAME##_method>(      \
+        ARCH_PP_ARG_NAMES(M_NARGS(__VA_ARGS__), __VA_ARGS__));                 \
+  }
+
+// An operator is satisfied by a member with the exact signature, const or
+// not, or failing that by a free operator op(T &, args...)
+#define ARCH_PP_METHOD_CALLER_OPERATOR(ARCH_PP_UNIQUE_NAME, ret, op, ...)      \
+  template <typename T, typename = void>                                       \
+  struct _##ARCH_PP_UNIQUE_NAME##_mutable : std::false_type {};                \
+                                                                               \
+  template <typename T>                                                        \
+  struct _##ARCH_PP_UNIQUE_NAME##_mutable<                                     \
+      T, archetype::void_t<decltype(static_cast<ret (T::*)(                    \
+             TYPED_ARGS(M_NARGS(__VA_ARGS__), __VA_ARGS__))>(&T::operator op))>>\
+      : std::true_type {};                                                     \
+                                                                               \
+  template <typename T, typename = void>                                       \
+  struct _##ARCH_PP_UNIQUE_NAME##_const : std::false_type {};                  \
+                                                                               \
+  template <typename T>                                                        \
+  struct _##ARCH_PP_UNIQUE_NAME##_const<                                       \
+      T, archetype::void_t<decltype(static_cast<ret (T::*)(                    \
+             TYPED_ARGS(M_NARGS(__VA_ARGS__), __VA_ARGS__)) const>(            \
+             &T::operator op))>> : std::true_type {};                          \
+                                                                               \
+  template <typename T>                                                        \
+  struct _##ARCH_PP_UNIQUE_NAME##_member                                       \
+      : std::integral_constant<bool,                                           \
+                               _##ARCH_PP_UNIQUE_NAME##_mutable<T>::value ||   \
+                                   _##ARCH_PP_UNIQUE_NAME##_const<T>::value> {};\
+                                                                               \
+  template <typename T, typename = void>                                       \
+  struct _##ARCH_PP_UNIQUE_NAME##_free : std::false_type {};                   \
+                                                                               \
+  template <typename T>                                                        \
+  struct _##ARCH_PP_UNIQUE_NAME##_free<                                        \
+      T, archetype::void_t<decltype(static_cast<ret>(                          \
+             operator op(std::declval<T &>() ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__)\
+                             ARCH_PP_DECLVAL_ARGS(M_NARGS(__VA_ARGS__),        \
+                                                  __VA_ARGS__))))>>            \
+      : std::true_type {};                                                     \
+                                                                               \
+  struct _##ARCH_PP_UNIQUE_NAME##_method {                                     \
+    using _signature = ret(__VA_ARGS__);                                       \
+    static constexpr const char *_name() { return "operator" #op; }            \
+    static constexpr const char *_signature_name() {                           \
+      return #ret "(" #__VA_ARGS__ ")";                                        \
+    }                                                                          \
+                                                                               \
+    template <typename VTableType>                                             \
+    static constexpr decltype(&VTableType::_##ARCH_PP_UNIQUE_NAME##_stub)      \
+    _stub() { return &VTableType::_##ARCH_PP_UNIQUE_NAME##_stub; }             \
+                                                                               \
+    template <typename T>                                                      \
+    static ret _call(void *obj ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__)              \
+                         TYPED_ARGS(M_NARGS(__VA_ARGS__), __VA_ARGS__)) {      \
+      return _invoke(                                                          \
+          static_cast<T *>(obj),                                               \
+          std::integral_constant<bool,                                         \
+                                 _##ARCH_PP_UNIQUE_NAME##_member<T>::value>()  \
+              ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__)                               \
+                  ARCH_PP_ARG_NAMES(M_NARGS(__VA_ARGS__), __VA_ARGS__));       \
+    }                                                                          \
+                                                                               \
+    template <typename T>                                                      \
+    static ret _invoke(T *t, std::true_type ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__) \
+                           TYPED_ARGS(M_NARGS(__VA_ARGS__), __VA_ARGS__)) {    \
+      return t->operator op(                                                   \
+          ARCH_PP_ARG_NAMES(M_NARGS(__VA_ARGS__), __VA_ARGS__));               \
+    }                                                                          \
+                                                                               \
+    template <typename T>                                                      \
+    static ret _invoke(T *t, std::false_type ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__)\
+                           TYPED_ARGS(M_NARGS(__VA_ARGS__), __VA_ARGS__)) {    \
+      return operator op(*t ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__)                 \
+                             ARCH_PP_ARG_NAMES(M_NARGS(__VA_ARGS__), __VA_ARGS__));\
+    }                                                                          \
+  };
+
+#define ARCH_PP_REQUIREMENT_OPERATOR ARCH_PP_REQUIREMENT_METHOD
+
+// A field reads like a method returning type &, the view, dispatch and
+// forward expansions are shared
+#define ARCH_PP_METHOD_FIELD(ARCH_PP_UNIQUE_NAME, type, name)                  \
+  ARCH_PP_METHOD_METHOD(ARCH_PP_UNIQUE_NAME, type &, name, )
+#define ARCH_PP_DISPATCH_STUB_FIELD(ARCH_PP_UNIQUE_NAME, type, name)           \
+  ARCH_PP_DISPATCH_STUB_METHOD(ARCH_PP_UNIQUE_NAME, type &, name, )
+#define ARCH_PP_FORWARD_METHOD_FIELD(ARCH_PP_UNIQUE_NAME, type, name)          \
+  ARCH_PP_FORWARD_METHOD_METHOD(ARCH_PP_UNIQUE_NAME, type &, name, )
+
+#define ARCH_PP_CALLSTUB_MEMBER_FIELD(ARCH_PP_UNIQUE_NAME, type, name)         \
+  archetype::field_stub<type> _##ARCH_PP_UNIQUE_NAME##_stub;
+
+#define ARCH_PP_CALLSTUB_ASSIGNMENT_FIELD(ARCH_PP_UNIQUE_NAME, type, name)     \
+  _##ARCH_PP_UNIQUE_NAME##_stub.offset =                                       \
+      archetype::field_offset<T>(static_cast<type T::*>(&T::name));
+
+// Null views have no object, field_stub reads the null result for them
+#define ARCH_PP_NULLSTUB_ASSIGNMENT_FIELD(ARCH_PP_UNIQUE_NAME, type, name)     \
+  _##ARCH_PP_UNIQUE_NAME##_stub.offset = 0;
+
+// A field is satisfied by a non static data member of exactly type,
+// possibly inherited
+#define ARCH_PP_METHOD_CALLER_FIELD(ARCH_PP_UNIQUE_NAME, type, name)           \
+  template <typename T, typename = void>                                       \
+  struct _##ARCH_PP_UNIQUE_NAME##_member : std::false_type {};                 \
+                                                                               \
+  template <typename T>                                                        \
+  struct _##ARCH_PP_UNIQUE_NAME##_member<                                      \
+      T, archetype::void_t<decltype(static_cast<type T::*>(&T::name))>>        \
+      : std::true_type {};                                                     \
+                                                                               \
+  struct _##ARCH_PP_UNIQUE_NAME##_method {                                     \
+    using _signature = type &();                                               \
+    static constexpr const char *_name() { return #name; }                     \
+    static constexpr const char *_signature_name() { return #type " &()"; }    \
+                                                                               \
+    template <typename VTableType>                                             \
+    static constexpr decltype(&VTableType::_##ARCH_PP_UNIQUE_NAME##_stub)      \
+    _stub() { return &VTableType::_##ARCH_PP_UNIQUE_NAME##_stub; }             \
+                                                                               \
+    template <typename T>                                                      \
+    static type &_call(void *obj) { return static_cast<T *>(obj)->name; }      \
+  };
+
+#define ARCH_PP_REQUIREMENT_FIELD(ARCH_PP_UNIQUE_NAME, type, name)             \
+  &&_##ARCH_PP_UNIQUE_NAME##_member<T>::value
+#define ARCH_PP_METHOD_METHOD(ARCH_PP_UNIQUE_NAME, ret, name, ...)              \
+public:                                                                        \
+  ret name(TYPED_ARGS(M_NARGS(__VA_ARGS__), __VA_ARGS__)) {                    \
+    return _vtbl->_##ARCH_PP_UNIQUE_NAME##_stub(_obj ARCH_PP_COMMA_IF_ARGS(           \
+        __VA_ARGS__) ARCH_PP_ARG_NAMES(M_NARGS(__VA_ARGS__), __VA_ARGS__));    \
+  }
+
+#define ARCH_PP_CALLSTUB_ASSIGNMENT_METHOD(ARCH_PP_UNIQUE_NAME, ret, name, ...) \
+  _##ARCH_PP_UNIQUE_NAME##_stub =                                              \
+      &_##ARCH_PP_UNIQUE_NAME##_method::template _call<T>;
+
+// A method is satisfied by a member function with the exact signature, or
+// failing that by a free function name(T &, args...) found through argument
+// dependent lookup. _call<T> is the stub bound into the vtable for T.
+#define ARCH_PP_METHOD_CALLER_METHOD(ARCH_PP_UNIQUE_NAME, ret, name, ...)       \
+  ARCH_PP_METHOD_CALLER_IMPL(, ARCH_PP_UNIQUE_NAME, ret, name, __VA_ARGS__)
+
+// DESCRIPTION adds members to the method's description
+#define ARCH_PP_METHOD_CALLER_IMPL(DESCRIPTION, ARCH_PP_UNIQUE_NAME, ret, name, ...)\
+  template <typename T, typename = void>                                       \
+  struct _##ARCH_PP_UNIQUE_NAME##_member : std::false_type {};                 \
+                                                                               \
+  template <typename T>                                                        \
+  struct _##ARCH_PP_UNIQUE_NAME##_member<                                      \
+      T, archetype::void_t<decltype(static_cast<ret (T::*)(                    \
+             TYPED_ARGS(M_NARGS(__VA_ARGS__), __VA_ARGS__))>(&T::name))>>      \
+      : std::true_type {};                                                     \
+                                                                               \
+  template <typename T, typename = void>                                       \
+  struct _##ARCH_PP_UNIQUE_NAME##_free : std::false_type {};                   \
+                                                                               \
+  template <typename T>                                                        \
+  struct _##ARCH_PP_UNIQUE_NAME##_free<                                        \
+      T, archetype::void_t<decltype(static_cast<ret>(                          \
+             name(std::declval<T &>() ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__)       \
+                      ARCH_PP_DECLVAL_ARGS(M_NARGS(__VA_ARGS__),               \
+                                           __VA_ARGS__))))>>                   \
+      : std::true_type {};                                                     \
+                                                                               \
+  struct _##ARCH_PP_UNIQUE_NAME##_method {                                     \
+    /* compile time description of the method */                              \
+    using _signature = ret(__VA_ARGS__);                                       \
+    static constexpr const char *_name() { return #name; }                     \
+    static constexpr const char *_signature_name() {                           \
+      return #ret "(" #__VA_ARGS__ ")";                                        \
+    }                                                                          \
+    DESCRIPTION                                                                \
+                                                                               \
+    /* the stub member of a vtable */                                          \
+    template <typename VTableType>                                             \
+    static constexpr decltype(&VTableType::_##ARCH_PP_UNIQUE_NAME##_stub)      \
+    _stub() { return &VTableType::_##ARCH_PP_UNIQUE_NAME##_stub; }             \
+                                                                               \
+    template <typename T>                                                      \
+    static ret _call(void *obj ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__)              \
+                         TYPED_ARGS(M_NARGS(__VA_ARGS__), __VA_ARGS__)) {      \
+      return _invoke(                                                          \
+          static_cast<T *>(obj),                                               \
+          std::integral_constant<bool,                                         \
+                                 _##ARCH_PP_UNIQUE_NAME##_member<T>::value>()  \
+              ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__)                               \
+                  ARCH_PP_ARG_NAMES(M_NARGS(__VA_ARGS__), __VA_ARGS__));       \
+    }                                                                          \
+                                                                               \
+    template <typename T>                                                      \
+    static ret _invoke(T *t, std::true_type ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__) \
+                           TYPED_ARGS(M_NARGS(__VA_ARGS__), __VA_ARGS__)) {    \
+      return t->name(ARCH_PP_ARG_NAMES(M_NARGS(__VA_ARGS__), __VA_ARGS__));    \
+    }                                                                          \
+                                                                               \
+    template <typename T>                                                      \
+    static ret _invoke(T *t, std::false_type ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__)\
+                           TYPED_ARGS(M_NARGS(__VA_ARGS__), __VA_ARGS__)) {    \
+      return name(*t ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__)                        \
+                      ARCH_PP_ARG_NAMES(M_NARGS(__VA_ARGS__), __VA_ARGS__));   \
+    }                                                                          \
+  };
+
+#define ARCH_PP_METHOD_TYPE_METHOD(ARCH_PP_UNIQUE_NAME, ret, name, ...)         \
+  _##ARCH_PP_UNIQUE_NAME##_method
+
+#define ARCH_PP_NULLSTUB_ASSIGNMENT_METHOD(ARCH_PP_UNIQUE_NAME, ret, name, ...) \
+  _##ARCH_PP_UNIQUE_NAME##_stub =                                              \
+      [](void * ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__) __VA_ARGS__) -> ret {        \
+    return archetype::null_result<ret>::get();                                 \
+  };
+
+#define ARCH_PP_DISPATCH_STUB_METHOD(ARCH_PP_UNIQUE_NAME, ret, name, ...)       \
+  ret _##ARCH_PP_UNIQUE_NAME##_stub(void *obj ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__) \
+                   TYPED_ARGS(M_NARGS(__VA_ARGS__), __VA_ARGS__)) const {      \
+    return this->template _dispatch<ret, _##ARCH_PP_UNIQUE_NAME##_method>(     \
+        obj ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__)                                 \
+            ARCH_PP_ARG_NAMES(M_NARGS(__VA_ARGS__), __VA_ARGS__));             \
+  }
+
+#define ARCH_PP_FORWARD_METHOD_METHOD(ARCH_PP_UNIQUE_NAME, ret, name, ...)      \
+public:                                                                        \
+  typename BaseForward::template result<ret>::type name(                       \
+      TYPED_ARGS(M_NARGS(__VA_ARGS__), __VA_ARGS__)) {                         \
+    return this->template _forward<ret, _##ARCH_PP_UNIQUE_NAME##_method>(      \
+        ARCH_PP_ARG_NAMES(M_NARGS(__VA_ARGS__), __VA_ARGS__));                 \
+  }
+
+#define ARCH_PP_CALLSTUB_MEMBER_METHOD(ARCH_PP_UNIQUE_NAME, ret, name, ...)     \
+  ret (*_##ARCH_PP_UNIQUE_NAME##_stub)(                                        \
+      void *obj ARCH_PP_COMMA_IF_ARGS(__VA_ARGS__) __VA_ARGS__);
+
+#define ARCH_PP_UNIQUE_NAME(base)                                              \
+  ARCH_PP_CAT(ARCH_PP_CAT(ARCH_PP_CAT(ARCH_PP_CAT(base, _), __LINE__), _),     \
+              __COUNTER__)
+
+#define ARCH_PP_REQUIREMENT_METHOD(ARCH_PP_UNIQUE_NAME, ret, name, ...)         \
+  &&(_##ARCH_PP_UNIQUE_NAME##_member<T>::value ||                              \
+     _##ARCH_PP_UNIQUE_NAME##_free<T>::value)
+
+#define ARCH_PP_APPEND_CHECK(x) x::check<T>::value
+#define ARCH_PP_APPLY_VTABLE_HELPER(x) archetype::helper<x>::vtable
+#define ARCH_PP_APPLY_VIEW_LAYER_HELPER(x) archetype::helper<x>::view_layer
+#define ARCH_PP_APPLY_DISPATCH_HELPER(x) archetype::helper<x>::dispatch_vtable
+#define ARCH_PP_APPLY_FORWARD_HELPER(x) archetype::helper<x>::forward_layer
+#define ARCH_PP_APPLY_METHODS_HELPER(x) archetype::helper<x>::methods
+
+//-- Foundational macro utilities
+#define ARCH_PP_EXPAND(x) x
+
+#define ARCH_PP_FOR_EACH(M, ...)                                               \
+  ARCH_PP_EXPAND(ARCH_PP_GET_MACRO(__VA_ARGS__, FE10, FE9, FE8, FE7, FE6, FE5, FE4,    \
+                           FE3, FE2, FE1)(M, __VA_ARGS__))
+
+#define ARCH_PP_GET_MACRO(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, NAME, ...) NAME
+
+#define FE1(M, x) M x
+#define FE2(M, x, ...) M x FE1(M, __VA_ARGS__)
+#define FE3(M, x, ...) M x FE2(M, __VA_ARGS__)
+#define FE4(M, x, ...) M x FE3(M, __VA_ARGS__)
+#define FE5(M, x, ...) M x FE4(M, __VA_ARGS__)
+#define FE6(M, x, ...) M x FE5(M, __VA_ARGS__)
+#define FE7(M, x, ...) M x FE6(M, __VA_ARGS__)
+#define FE8(M, x, ...) M x FE7(M, __VA_ARGS__)
+#define FE9(M, x, ...) M x FE8(M, __VA_ARGS__)
+#define FE10(M, x, ...) M x FE9(M, __VA_ARGS__)
+
+#define FE1_2(M, T, x) M(T, x)
+#define FE2_2(M, T, x, ...) M(T, x) FE1_2(M, T, __VA_ARGS__)
+#define FE3_2(M, T, x, ...) M(T, x) FE2_2(M, T, __VA_ARGS__)
+#define FE4_2(M, T, x, ...) M(T, x) FE3_2(M, T, __VA_ARGS__)
+#define FE5_2(M, T, x, ...) M(T, x) FE4_2(M, T, __VA_ARGS__)
+#define FE6_2(M, T, x, ...) M(T, x) FE5_2(M, T, __VA_ARGS__)
+#define FE7_2(M, T, x, ...) M(T, x) FE6_2(M, T, __VA_ARGS__)
+#define FE8_2(M, T, x, ...) M(T, x) FE7_2(M, T, __VA_ARGS__)
+#define FE9_2(M, T, x, ...) M(T, x) FE8_2(M, T, __VA_ARGS__)
+#define FE10_2(M, T, x, ...) M(T, x) FE9_2(M, T, __VA_ARGS__)
+
+#define ARCH_PP_FOR_EACH_SEP(M, ...)                                           \
+  ARCH_PP_EXPAND(ARCH_PP_GET_MACRO(__VA_ARGS__, FES10, FES9, FES8, FES7, FES6, FES5,   \
+                           FES4, FES3, FES2, FES1)(M, __VA_ARGS__))
+
+#define FES1(M, x) M x
+#define FES2(M, x, ...) M x, FES1(M, __VA_ARGS__)
+#define FES3(M, x, ...) M x, FES2(M, __VA_ARGS__)
+#define FES4(M, x, ...) M x, FES3(M, __VA_ARGS__)
+#define FES5(M, x, ...) M x, FES4(M, __VA_ARGS__)
+#define FES6(M, x, ...) M x, FES5(M, __VA_ARGS__)
+#define FES7(M, x, ...) M x, FES6(M, __VA_ARGS__)
+#define FES8(M, x, ...) M x, FES7(M, __VA_ARGS__)
+#define FES9(M, x, ...) M x, FES8(M, __VA_ARGS__)
+#define FES10(M, x, ...) M x, FES9(M, __VA_ARGS__)
+
+#define FES1_2(M, T, x) M(T, x)
+#define FES2_2(M, T, x, ...) M(T, x), FES1_2(M, T, __VA_ARGS__)
+#define FES3_2(M, T, x, ...) M(T, x), FES2_2(M, T, __VA_ARGS__)
+#define FES4_2(M, T, x, ...) M(T, x), FES3_2(M, T, __VA_ARGS__)
+#define FES5_2(M, T, x, ...) M(T, x), FES4_2(M, T, __VA_ARGS__)
+#define FES6_2(M, T, x, ...) M(T, x), FES5_2(M, T, __VA_ARGS__)
+#define FES7_2(M, T, x, ...) M(T, x), FES6_2(M, T, __VA_ARGS__)
+#define FES8_2(M, T, x, ...) M(T, x), FES7_2(M, T, __VA_ARGS__)
+#define FES9_2(M, T, x, ...) M(T, x), FES8_2(M, T, __VA_ARGS__)
+#define FES10_2(M, T, x, ...) M(T, x), FES9_2(M, T, __VA_ARGS__)
+
+#define ARCH_PP_FOR_EACH_CALL_1(M, a1) M(a1)
+#define ARCH_PP_FOR_EACH_CALL_2(M, a1, a2) M(a1) M(a2)
+#define ARCH_PP_FOR_EACH_CALL_3(M, a1, a2, a3) M(a1) M(a2) M(a3)
+#define ARCH_PP_FOR_EACH_CALL_4(M, a1, a2, a3, a4) M(a1) M(a2) M(a3) M(a4)
+#define ARCH_PP_FOR_EACH_CALL_5(M, a1, a2, a3, a4, a5)                         \
+  M(a1) M(a2) M(a3) M(a4) M(a5)
+#define ARCH_PP_FOR_EACH_CALL_6(M, a1, a2, a3, a4, a5, a6)                     \
+  M(a1) M(a2) M(a3) M(a4) M(a5) M(a6)
+#define ARCH_PP_FOR_EACH_CALL_7(M, a1, a2, a3, a4, a5, a6, a7)                 \
+  M(a1) M(a2) M(a3) M(a4) M(a5) M(a6) M(a7)
+#define ARCH_PP_FOR_EACH_CALL_8(M, a1, a2, a3, a4, a5, a6, a7, a8)             \
+  M(a1) M(a2) M(a3) M(a4) M(a5) M(a6) M(a7) M(a8)
+
+#define ARCH_PP_FOR_EACH_CALL(M, ...)                                          \
+  ARCH_PP_GET_FOR_EACH_CALL(M_NARGS(__VA_ARGS__))(M, __VA_ARGS__)
+
+#define ARCH_PP_GET_FOR_EACH_CALL(N) ARCH_PP_CAT(ARCH_PP_FOR_EACH_CALL_, N)
+
+#define ARCH_PP_FOR_EACH_SEP_CALL_1(M, a1) M(a1)
+#define ARCH_PP_FOR_EACH_SEP_CALL_2(M, a1, a2) M(a1), M(a2)
+#define ARCH_PP_FOR_EACH_SEP_CALL_3(M, a1, a2, a3) M(a1), M(a2), M(a3)
+#define ARCH_PP_FOR_EACH_SEP_CALL_4(M, a1, a2, a3, a4)                         \
+  M(a1), M(a2), M(a3), M(a4)
+#define ARCH_PP_FOR_EACH_SEP_CALL_5(M, a1, a2, a3, a4, a5)                     \
+  M(a1), M(a2), M(a3), M(a4), M(a5)
+#define ARCH_PP_FOR_EACH_SEP_CALL_6(M, a1, a2, a3, a4, a5, a6)                 \
+  M(a1), M(a2), M(a3), M(a4), M(a5), M(a6)
+#define ARCH_PP_FOR_EACH_SEP_CALL_7(M, a1, a2, a3, a4, a5, a6, a7)             \
+  M(a1), M(a2), M(a3), M(a4), M(a5), M(a6), M(a7)
+#define ARCH_PP_FOR_EACH_SEP_CALL_8(M, a1, a2, a3, a4, a5, a6, a7, a8)         \
+  M(a1), M(a2), M(a3), M(a4), M(a5), M(a6), M(a7), M(a8)
+
+#define ARCH_PP_FOR_EACH_SEP_CALL(M, ...)                                      \
+  ARCH_PP_GET_FOR_EACH_SEP_CALL(M_NARGS(__VA_ARGS__))(M, __VA_ARGS__)
+
+#define ARCH_PP_GET_FOR_EACH_SEP_CALL(N)                                       \
+  ARCH_PP_CAT(ARCH_PP_FOR_EACH_SEP_CALL_, N)
+
+#define ARCH_PP_FOR_EACH_SEPX_CALL_1(M, X, a1) M(a1)
+#define ARCH_PP_FOR_EACH_SEPX_CALL_2(M, X, a1, a2) M(a1) X M(a2)
+#define ARCH_PP_FOR_EACH_SEPX_CALL_3(M, X, a1, a2, a3)                         \
+  M(a1) X M(a2)                                                                \
+  X M(a3)
+#define ARCH_PP_FOR_EACH_SEPX_CALL_4(M, X, a1, a2, a3, a4)                     \
+  M(a1) X M(a2)                                                                \
+  X M(a3)                                                                      \
+  X M(a4)
+#define ARCH_PP_FOR_EACH_SEPX_CALL_5(M, X, a1, a2, a3, a4, a5)                 \
+  M(a1) X M(a2)                                                                \
+  X M(a3)                                                                      \
+  X M(a4)                                                                      \
+  X M(a5)
+#define ARCH_PP_FOR_EACH_SEPX_CALL_6(M, X, a1, a2, a3, a4, a5, a6)             \
+  M(a1) X M(a2)                                                                \
+  X M(a3)                                                                      \
+  X M(a4)                                                                      \
+  X M(a5)                                                                      \
+  X M(a6)
+#define ARCH_PP_FOR_EACH_SEPX_CALL_7(M, a1, a2, a3, a4, a5, a6, a7)            \
+  M(a1) X M(a2)                                                                \
+  X M(a3)                                                                      \
+  X M(a4)                                                                      \
+  X M(a5)                                                                      \
+  X M(a6)                                                                      \
+  X M(a7)
+#define ARCH_PP_FOR_EACH_SEPX_CALL_8(M, a1, a2, a3, a4, a5, a6, a7, a8)        \
+  M(a1) X M(a2)                                                                \
+  X M(a3)                                                                      \
+  X M(a4)                                                                      \
+  X M(a5)                                                                      \
+  X M(a6)                                                                      \
+  X M(a7)                                                                      \
+  X M(a8)
+
+#define ARCH_PP_FOR_EACH_SEPX_CALL(M, X, ...)                                  \
+  ARCH_PP_GET_FOR_EACH_SEPX_CALL(M_NARGS(__VA_ARGS__))(M, X, __VA_ARGS__)
+
+#define ARCH_PP_GET_FOR_EACH_SEPX_CALL(N)                                      \
+  ARCH_PP_CAT(ARCH_PP_FOR_EACH_SEPX_CALL_, N)
+
+// count arguments - ##__VA_ARGS__ is not portable
+#define M_NARGS(...)                                                           \
+  M_NARGS_(dummy, ##__VA_ARGS__, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define M_NARGS_(_10, _9, _8, _7, _6, _5, _4, _3, _2, _1, N, ...) N
+
+// has arguments - ##__VA_ARGS__ is not portable
+#define HAS_ARGS(...)                                                          \
+  HAS_ARGS_IMPL(dummy, ##__VA_ARGS__, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0)
+#define HAS_ARGS_IMPL(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, N, ...) N
+#define ARCH_PP_COMMA_IF_ARGS(...)                                             \
+  ARCH_PP_COMMA_IF_ARGS_IMPL(HAS_ARGS(__VA_ARGS__))
+#define ARCH_PP_COMMA_IF_ARGS_IMPL(has_args)                                   \
+  M_CONC(ARCH_PP_COMMA_IF_ARGS_, has_args)
+#define ARCH_PP_COMMA_IF_ARGS_1 ,
+#define ARCH_PP_COMMA_IF_ARGS_0
+
+// utility (concatenation)
+#define M_CONC(A, B) M_CONC_(A, B)
+#define M_CONC_(A, B) A##B
+
+#define M_GET_ELEM(N, ...) M_CONC(M_GET_ELEM_, N)(__VA_ARGS__)
+#define M_GET_ELEM_0(_0, ...) _0
+#define M_GET_ELEM_1(_0, _1, ...) _1
+#define M_GET_ELEM_2(_0, _1, _2, ...) _2
+#define M_GET_ELEM_3(_0, _1, _2, _3, ...) _3
+#define M_GET_ELEM_4(_0, _1, _2, _3, _4, ...) _4
+#define M_GET_ELEM_5(_0, _1, _2, _3, _4, _5, ...) _5
+#define M_GET_ELEM_6(_0, _1, _2, _3, _4, _5, _6, ...) _6
+#define M_GET_ELEM_7(_0, _1, _2, _3, _4, _5, _6, _7, ...) _7
+#define M_GET_ELEM_8(_0, _1, _2, _3, _4, _5, _6, _7, _8, ...) _8
+#define M_GET_ELEM_9(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, ...) _9
+#define M_GET_ELEM_10(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, ...) _10
+
+// Get last argument - placeholder decrements by one
+#define M_GET_LAST(...)                                                        \
+  M_GET_ELEM(M_NARGS(__VA_ARGS__), _, __VA_ARGS__, , , , , , , , , , , )
+
+#define ARCH_PP_CAT(a, b) ARCH_PP_CAT_IMPL(a, b)
+#define ARCH_PP_CAT_IMPL(a, b) a##b
+
+#define STRINGIFY(x) STRINGIFY_IMPL(x)
+#define STRINGIFY_IMPL(x) #x
+
+#define FUNC_SIGNATURE(ret, name, ...) ret name(__VA_ARGS__)
+
+#define NUM_ARGS(...) NUM_ARGS_IMPL(__VA_ARGS__, 5, 4, 3, 2, 1, 0)
+#define NUM_ARGS_IMPL(_1, _2, _3, _4, _5, N, ...) N
+
+#define TYPED_ARG_0()
+#define TYPED_ARG_1(t0) t0 arg0
+#define TYPED_ARG_2(t0, t1) t0 arg0, t1 arg1
+#define TYPED_ARG_3(t0, t1, t2) t0 arg0, t1 arg1, t2 arg2
+#define TYPED_ARG_4(t0, t1, t2, t3) t0 arg0, t1 arg1, t2 arg2, t3 arg3
+// Extend as needed...
+
+#define TYPED_ARGS(count, ...) ARCH_PP_CAT(TYPED_ARG_, count)(__VA_ARGS__)
+
+#define ARCH_PP_DECLVAL_ARGS_0()
+#define ARCH_PP_DECLVAL_ARGS_1(t0) std::declval<t0>()
+#define ARCH_PP_DECLVAL_ARGS_2(t0, t1) std::declval<t0>(), std::declval<t1>()
+#define ARCH_PP_DECLVAL_ARGS_3(t0, t1, t2)                                     \
+  std::declval<t0>(), std::declval<t1>(), std::declval<t2>()
+#define ARCH_PP_DECLVAL_ARGS_4(t0, t1, t2, t3)                                 \
+  std::declval<t0>(), std::declval<t1>(), std::declval<t2>(), std::declval<t3>()
+
+#define ARCH_PP_DECLVAL_ARGS(count, ...)                                       \
+  ARCH_PP_CAT(ARCH_PP_DECLVAL_ARGS_, count)(__VA_ARGS__)
+
+#define ARCH_PP_ARG_NAMES_0()
+#define ARCH_PP_ARG_NAMES_1(t0) arg0
+#define ARCH_PP_ARG_NAMES_2(t0, t1) arg0, arg1
+#define ARCH_PP_ARG_NAMES_3(t0, t1, t2) arg0, arg1, arg2
+#define ARCH_PP_ARG_NAMES_4(t0, t1, t2, t3) arg0, arg1, arg2, arg3
+
+#define ARCH_PP_TEMPLATE_CHAIN(...)                                            \
+  ARCH_PP_TEMPLATE_CHAIN_DISPATCH(M_NARGS(__VA_ARGS__), __VA_ARGS__)
+#define ARCH_PP_TEMPLATE_CHAIN_DISPATCH(N, ...)                                \
+  ARCH_PP_CAT(ARCH_PP_TEMPLATE_CHAIN_, N)(__VA_ARGS__)
+#define ARCH_PP_TEMPLATE_CHAIN_1(t0) t0
+#define ARCH_PP_TEMPLATE_CHAIN_2(t0, t1) t0<t1>
+#define ARCH_PP_TEMPLATE_CHAIN_3(t0, t1, t2) t0<t1<t2>>
+#define ARCH_PP_TEMPLATE_CHAIN_4(t0, t1, t2, t3) t0<t1<t2<t3>>>
+#define ARCH_PP_TEMPLATE_CHAIN_5(t0, t1, t2, t3, t4) t0<t1<t2<t3<t4>>>>
+#define ARCH_PP_TEMPLATE_CHAIN_6(t0, t1, t2, t3, t4, t5) t0<t1<t2<t3<t4<t5>>>>>
+#define ARCH_PP_TEMPLATE_CHAIN_7(t0, t1, t2, t3, t4, t5, t6)                   \
+  t0<t1<t2<t3<t4<t5<t6>>>>>>
+#define ARCH_PP_TEMPLATE_CHAIN_8(t0, t1, t2, t3, t4, t5, t6, t7)               \
+  t0<t1<t2<t3<t4<t5<t6<t7>>>>>>>
+#define ARCH_PP_TEMPLATE_CHAIN_9(t0, t1, t2, t3, t4, t5, t6, t7, t8)           \
+  t0<t1<t2<t3<t4<t5<t6<t7<t8>>>>>>>>
+#define ARCH_PP_TEMPLATE_CHAIN_10(t0, t1, t2, t3, t4, t5, t6, t7, t8, t9)      \
+  t0<t1<t2<t3<t4<t5<t6<t7<t8<t9>>>>>>>>>
+
+#define ARCH_PP_ARG_NAMES(count, ...)                                          \
+  ARCH_PP_CAT(ARCH_PP_ARG_NAMES_, count)(__VA_ARGS__)
+
+#endif //__ARCHETYPE_MACROS_H__
@@ -0,0 +1,242 @@
+#ifndef __ARCHETYPE_MEMO_CACHE_H__
+#define __ARCHETYPE_MEMO_CACHE_H__
+
+#include "archetype/archetype.h"
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace archetype {
+
+  template <class Archetype>
+  class memo_cache;
+
+  template <class Archetype>
+  class memo_cache_base
+  {
+    public:
+    template <typename R>
+    struct result { using type = R; };
+
+    protected:
+    using view = typename Archetype::view;
+
+    // Pure methods go through the cache, others straight to the view
+    template <typename R, typename Method, typename... Args>
+    R _forward(Args &&... args)
+    {
+      return _memoize<R, Method>(is_pure_method<Method>(), std::forward<Args>(args)...);
+    }
+
+    template <typename R, typename Method, typename... Args>
+    R _memoize(std::false_type, Args &&... args)
+    {
+      return Method::template _call<view>(&_view, std::forward<Args>(args)...);
+    }
+
+    template <typename R, typename Method, typename... Args>
+    R _memoize(std::true_type, Args &&... args)
+    {
+      return _cache->template _lookup<R, Method>(_view, args...);
+    }
+
+    memo_cache<Archetype> * _cache;
+    view _view;
+  };
+
+  // Remembers the results of the pure methods of Archetype, declared with
+  // ARCHETYPE_PURE_METHOD, per binding and arguments, so a repeated call
+  // costs a hash and a compare instead of a call through the vtable. Each
+  // pure method has a table of capacity entries, allocated on its first
+  // call, where a new result replaces the one in its slot, so the cache
+  // never grows and doesn't allocate after that. Arguments must be
+  // hashable by std::hash and equality comparable, results default
+  // constructible and copyable. When an object changes, invalidate its
+  // results. Other methods are called through the view. Not thread safe.
+  //
+  //   archetype::memo_cache<planner> cache;
+  //   double c = cache(v).cost(query);
+  template <class Archetype>
+  class memo_cache
+  {
+    using view = typename Archetype::view;
+
+    public:
+    // The methods of Archetype, called through the cache
+    class call
+        : public helper<Archetype>::template forward_layer<memo_cache_base<Archetype>>
+    {
+      friend class memo_cache;
+    };
+
+    explicit memo_cache(std::size_t capacity = 256) : _generation(1)
+    {
+      std::size_t size = 1;
+      _shift = sizeof(std::size_t) * 8;
+      while (size < capacity) {
+        size *= 2;
+        _shift--;
+      }
+      _size = size;
+      for (auto & t : _tables) { t.entries = nullptr; }
+      reset_stats();
+    }
+
+    ~memo_cache()
+    {
+      for (auto & t : _tables) {
+        if (t.entries) { t.destroy(t.entries); }
+      }
+    }
+
+    memo_cache(const memo_cache &) = delete;
+    memo_cache & operator=(const memo_cache &) = delete;
+
+    call operator()(const view & v)
+    {
+      call c;
+      c._cache = this;
+      c._view = v;
+      return c;
+    }
+
+    // Forgets every result
+    void invalidate() { _generation++; }
+
+    // Forgets the results for the object v is bound to
+    void invalidate(const view & v)
+    {
+      for (auto & t : _tables) {
+        if (t.entries) { t.erase(t.entries, _size, access::obj(v)); }
+      }
+    }
+
+    std::size_t capacity() const { return _size; }
+
+    std::size_t hits() const { return _hits; }
+    std::size_t misses() const { return _misses; }
+
+    double hit_rate() const
+    {
+      std::size_t total = _hits + _misses;
+      return total ? static_cast<double>(_hits) / static_cast<double>(total) : 0.0;
+    }
+
+    void reset_stats() { _hits = _misses = 0; }
+
+    private:
+    friend class memo_cache_base<Archetype>;
+
+    template <typename List> struct method_count;
+
+    template <typename... Ms>
+    struct method_count<type_list<Ms...>>
+        : std::integral_constant<std::size_t, sizeof...(Ms)> {};
+
+    template <typename Method, typename List> struct method_index;
+
+    template <typename Method, typename... Ms>
+    struct method_index<Method, type_list<Ms...>> : index_of<Method, Ms...> {};
+
+    using methods = typename helper<Archetype>::methods;
+
+    // An entry is current when its generation is the cache's. The vtable
+    // tells apart an object and its first member, which share an address.
+    template <typename R, typename Key>
+    struct entry
+    {
+      std::size_t generation;
+      const void * obj;
+      const void * vtbl;
+      Key key;
+      R value;
+    };
+
+    struct table
+    {
+      void * entries;
+      void (*destroy)(void *);
+      void (*erase)(void *, std::size_t, const void *);
+    };
+
+    template <typename Entry>
+    static void _destroy(void * entries) { delete[] static_cast<Entry *>(entries); }
+
+    template <typename Entry>
+    static void _erase(void * entries, std::size_t size, const void * obj)
+    {
+      Entry * e = static_cast<Entry *>(entries);
+      for (std::size_t i = 0; i < size; i++) {
+        if (e[i].obj == obj) { e[i].generation = 0; }
+      }
+    }
+
+    template <typename Entry>
+    Entry * _entries(std::size_t method)
+    {
+      table & t = _tables[method];
+      if (!t.entries) {
+        t.entries = new Entry[_size]();
+        t.destroy = &_destroy<Entry>;
+        t.erase = &_erase<Entry>;
+      }
+      return static_cast<Entry *>(t.entries);
+    }
+
+    static std::size_t _mix(std::size_t h, std::size_t v)
+    {
+      return h ^ (v + static_cast<std::size_t>(0x9e3779b97f4a7c15ull) + (h << 6) + (h >> 2));
+    }
+
+    // Fibonacci hashing spreads the identity hashes of pointers and
+    // integers over the table
+    template <typename... Args>
+    std::size_t _slot(const void * obj, const void * vtbl, const Args &... args) const
+    {
+      std::size_t h = _mix(std::hash<const void *>()(obj), std::hash<const void *>()(vtbl));
+      int mixed[] = {0, (h = _mix(h, std::hash<Args>()(args)), 0)...};
+      (void)mixed;
+      std::size_t s = h * static_cast<std::size_t>(0x9e3779b97f4a7c15ull);
+      return _shift < sizeof(std::size_t) * 8 ? s >> _shift : 0;
+    }
+
+    template <typename R, typename Method, typename... Args>
+    R _lookup(view & v, Args &... args)
+    {
+      static_assert(!std::is_void<R>::value && !std::is_reference<R>::value,
+                    "pure methods must return a value");
+      using key_type = std::tuple<typename std::decay<Args>::type...>;
+      using entry_type = entry<R, key_type>;
+
+      void * obj = access::obj(v);
+      const void * vtbl = access::vtbl(v);
+      entry_type & e = _entries<entry_type>(method_index<Method, methods>::value)[
+          _slot(obj, vtbl, static_cast<const typename std::decay<Args>::type &>(args)...)];
+      if (e.generation == _generation && e.obj == obj && e.vtbl == vtbl &&
+          e.key == std::tie(args...)) {
+        _hits++;
+        return e.value;
+      }
+      _misses++;
+      R r = Method::template _call<view>(&v, args...);
+      e.generation = _generation;
+      e.obj = obj;
+      e.vtbl = vtbl;
+      e.key = key_type(args...);
+      e.value = r;
+      return r;
+    }
+
+    table _tables[method_count<methods>::value];
+    std::size_t _size;
+    std::size_t _shift;
+    std::size_t _generation;
+    std::size_t _hits;
+    std::size_t _misses;
+  };
+
+} // namespace archetype
+
+#endif //__ARCHETYPE_MEMO_CACHE_H__
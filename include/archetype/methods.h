@@ -0,0 +1,232 @@
+#ifndef __ARCHETYPE_METHODS_H__
+#define __ARCHETYPE_METHODS_H__
+
+#include "archetype/archetype.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+namespace archetype {
+
+  // FNV-1a of a string with a seed, usable in constant expressions
+  constexpr std::uint32_t name_hash(const char * s, std::uint32_t h) {
+    return *s ? name_hash(s + 1, (h ^ static_cast<unsigned char>(*s)) * 16777619u)
+              : h;
+  }
+
+  constexpr std::uint32_t name_slot(const char * s, std::uint32_t seed,
+                                    std::size_t size) {
+    return (name_hash(s, 2166136261u ^ (seed * 0x9e3779b9u)) >> 7) &
+           static_cast<std::uint32_t>(size - 1);
+  }
+
+  constexpr bool name_equal(const char * a, const char * b) {
+    return *a == *b && (*a == 0 || name_equal(a + 1, b + 1));
+  }
+
+  template <std::size_t N>
+  struct name_array
+  {
+    const char * v[N];
+    constexpr const char * operator[](std::size_t i) const { return v[i]; }
+  };
+
+  // Stores the result of a call in caller provided storage, an R for value
+  // results and an R * for reference results
+  template <typename R>
+  struct store_result {
+    template <typename F>
+    static void call(void * result, F f) { new (result) R(f()); }
+  };
+
+  template <typename R>
+  struct store_result<R &> {
+    template <typename F>
+    static void call(void * result, F f) { *static_cast<R **>(result) = &f(); }
+  };
+
+  template <>
+  struct store_result<void> {
+    template <typename F>
+    static void call(void *, F f) { f(); }
+  };
+
+  // Calls a method with arguments given as an array of pointers
+  template <typename View, typename Method, typename Signature>
+  struct erased_call;
+
+  template <typename View, typename Method, typename R, typename... Args>
+  struct erased_call<View, Method, R(Args...)>
+  {
+    static void call(View & v, void * const * args, void * result)
+    {
+      _call(v, args, result, typename make_indices<sizeof...(Args)>::type());
+    }
+
+    template <std::size_t... Is>
+    static void _call(View & v, void * const * args, void * result, indices<Is...>)
+    {
+      (void)args;
+      store_result<R>::call(result, [&]() -> R {
+        return Method::template _call<View>(
+            &v, *static_cast<typename std::remove_reference<Args>::type *>(
+                    args[Is])...);
+      });
+    }
+  };
+
+  // Names and signatures of a list of method descriptors, usable in
+  // constant expressions
+  template <typename... Ms>
+  struct method_names
+  {
+    static constexpr std::size_t size = sizeof...(Ms);
+
+    static constexpr const char * name(std::size_t i) {
+      return name_array<size>{{Ms::_name()...}}[i];
+    }
+
+    static constexpr const char * signature(std::size_t i) {
+      return name_array<size>{{Ms::_signature_name()...}}[i];
+    }
+
+    // Declaration index of the method called n, or size when there is none.
+    // Linear, intended for constant expressions.
+    static constexpr std::size_t find(const char * n, std::size_t i = 0) {
+      return i == size ? size : name_equal(name(i), n) ? i : find(n, i + 1);
+    }
+
+    static constexpr bool unique(std::size_t i = 0) {
+      return i >= size || (_unique_from(i, i + 1) && unique(i + 1));
+    }
+
+    // true if no two names share a slot of a table of the given size
+    static constexpr bool perfect(std::uint32_t seed, std::size_t table,
+                                  std::size_t i = 0) {
+      return i >= size || (_distinct_from(seed, table, i, i + 1) &&
+                           perfect(seed, table, i + 1));
+    }
+
+    static constexpr std::size_t initial_table(std::size_t t = 1) {
+      return t >= 2 * size ? t : initial_table(t * 2);
+    }
+
+    static constexpr bool _unique_from(std::size_t i, std::size_t j) {
+      return j >= size || (!name_equal(name(i), name(j)) && _unique_from(i, j + 1));
+    }
+
+    static constexpr bool _distinct_from(std::uint32_t seed, std::size_t table,
+                                         std::size_t i, std::size_t j) {
+      return j >= size || (name_slot(name(i), seed, table) !=
+                               name_slot(name(j), seed, table) &&
+                           _distinct_from(seed, table, i, j + 1));
+    }
+  };
+
+  // Finds a seed giving a perfect hash, trying 32 seeds per table size
+  // before doubling the table
+  template <typename Names, std::uint32_t Seed, std::size_t Table,
+            bool Found = Names::perfect(Seed, Table)>
+  struct perfect_hash_search
+      : perfect_hash_search<Names, (Seed + 1) % 32,
+                            (Seed + 1 == 32 ? Table * 2 : Table)> {};
+
+  template <typename Names, std::uint32_t Seed, std::size_t Table>
+  struct perfect_hash_search<Names, Seed, Table, true>
+  {
+    static constexpr std::uint32_t seed = Seed;
+    static constexpr std::size_t table_size = Table;
+  };
+
+  template <class Archetype, typename Methods = typename helper<Archetype>::methods>
+  struct method_table;
+
+  // Compile time description of the methods of Archetype, in declaration
+  // order with components first, and O(1) dispatch by name through a
+  // perfect hash built at compile time.
+  template <class Archetype, typename... Ms>
+  struct method_table<Archetype, type_list<Ms...>> : method_names<Ms...>
+  {
+    using names = method_names<Ms...>;
+    using view = typename Archetype::view;
+
+    static_assert(names::unique(), "dispatch by name needs unique method names");
+
+    // Calls a method on v, args[i] points at the i-th argument and result
+    // at storage for the return value
+    using thunk = void (*)(view & v, void * const * args, void * result);
+
+    struct entry
+    {
+      const char * name;
+      const char * signature;
+      thunk call;
+    };
+
+    static constexpr std::uint32_t seed =
+        perfect_hash_search<names, 0, names::initial_table()>::seed;
+    static constexpr std::size_t table_size =
+        perfect_hash_search<names, 0, names::initial_table()>::table_size;
+
+    // Entry for the method called n, or nullptr
+    static const entry * lookup(const char * n)
+    {
+      std::uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+      for (const char * c = n; *c; c++) {
+        h = (h ^ static_cast<unsigned char>(*c)) * 16777619u;
+      }
+      const entry & e = _entries()[(h >> 7) & (table_size - 1)];
+      return e.name && std::strcmp(e.name, n) == 0 ? &e : nullptr;
+    }
+
+    // Calls the method called n on v. Returns false, without calling
+    // anything, when there is no such method.
+    static bool invoke(view & v, const char * n, void * const * args, void * result)
+    {
+      const entry * e = lookup(n);
+      if (!e) { return false; }
+      e->call(v, args, result);
+      return true;
+    }
+
+    private:
+    // Entry of the method hashed to Slot, searching from method I
+    template <std::size_t Slot, std::size_t I = 0, bool End = (I == sizeof...(Ms))>
+    struct _at
+    {
+      using method = typename type_at<I, Ms...>::type;
+
+      static constexpr entry get() {
+        return name_slot(method::_name(), seed, table_size) == Slot
+                   ? entry{method::_name(), method::_signature_name(),
+                           &erased_call<view, method,
+                                        typename method::_signature>::call}
+                   : _at<Slot, I + 1>::get();
+      }
+    };
+
+    template <std::size_t Slot, std::size_t I>
+    struct _at<Slot, I, true>
+    {
+      static constexpr entry get() { return entry{nullptr, nullptr, nullptr}; }
+    };
+
+    template <std::size_t... Slots>
+    static const entry * _fill(indices<Slots...>)
+    {
+      // constant initialised, there is no guard on the lookup path
+      static const entry entries[] = {_at<Slots>::get()...};
+      return entries;
+    }
+
+    static const entry * _entries()
+    {
+      return _fill(typename make_indices<table_size>::type());
+    }
+  };
+
+} // namespace archetype
+
+#endif //__ARCHETYPE_METHODS_H__
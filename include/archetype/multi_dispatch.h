@@ -0,0 +1,134 @@
+#ifndef __ARCHETYPE_MULTI_DISPATCH_H__
+#define __ARCHETYPE_MULTI_DISPATCH_H__
+
+#include "archetype/archetype.h"
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace archetype {
+
+  template <class Archetype1, class Archetype2, typename Signature>
+  class multi_dispatch;
+
+  // Picks a handler by the types bound to two views, for when behaviour
+  // depends on both, like collisions. The table is indexed by the dense
+  // vtable index of each view, so a call is two index loads, a table load
+  // and one indirect call. Pairs without a handler go to the fallback.
+  //
+  //   archetype::multi_dispatch<body, body, int(contact &)> collide;
+  //   collide.add<circle, box, &circle_box>();
+  //   collide(a, b, c);
+  //
+  // Handlers take the bound objects, R f(T1 &, T2 &, Args...). Only
+  // registered pairs instantiate anything, and the table is sized by the
+  // types registered with this instance, so nothing is done per pair of
+  // types at static init. Register handlers before calling from several
+  // threads, add is not synchronised with calls.
+  template <class Archetype1, class Archetype2, typename R, typename... Args>
+  class multi_dispatch<Archetype1, Archetype2, R(Args...)>
+  {
+    public:
+    using first_view = typename Archetype1::view;
+    using second_view = typename Archetype2::view;
+    using handler = R (*)(const first_view &, const second_view &, Args...);
+
+    // By default unhandled pairs return what a null view would
+    explicit multi_dispatch(handler fallback = &_null_fallback)
+        : _fallback(fallback), _rows(0), _cols(0) {}
+
+    template <typename T1, typename T2, R (*F)(T1 &, T2 &, Args...)>
+    multi_dispatch & add()
+    {
+      static_assert(Archetype1::template check<T1>::value,
+                    "T1 must satisfy Archetype1::check");
+      static_assert(Archetype2::template check<T2>::value,
+                    "T2 must satisfy Archetype2::check");
+      _set(_index1<T1>(), _index2<T2>(), &_thunk<T1, T2, F>);
+      return *this;
+    }
+
+    // Registers F for (T1, T2) and, with the arguments swapped, for
+    // (T2, T1). Both archetypes must be the same.
+    template <typename T1, typename T2, R (*F)(T1 &, T2 &, Args...)>
+    multi_dispatch & add_symmetric()
+    {
+      static_assert(std::is_same<Archetype1, Archetype2>::value,
+                    "add_symmetric needs a single archetype");
+      add<T1, T2, F>();
+      _set(_index1<T2>(), _index2<T1>(), &_swapped_thunk<T1, T2, F>);
+      return *this;
+    }
+
+    R operator()(const first_view & a, const second_view & b, Args... args) const
+    {
+      std::size_t i = access::vtbl(a)->_index;
+      std::size_t j = access::vtbl(b)->_index;
+      handler h = i < _rows && j < _cols ? _table[i * _cols + j] : _fallback;
+      return h(a, b, std::forward<Args>(args)...);
+    }
+
+    // Whether a handler other than the fallback is registered for the
+    // pair of types bound to a and b
+    bool handles(const first_view & a, const second_view & b) const
+    {
+      std::size_t i = access::vtbl(a)->_index;
+      std::size_t j = access::vtbl(b)->_index;
+      return i < _rows && j < _cols && _table[i * _cols + j] != _fallback;
+    }
+
+    private:
+    template <typename T>
+    static std::size_t _index1() { return bound_vtable<Archetype1, T>::get()->_index; }
+
+    template <typename T>
+    static std::size_t _index2() { return bound_vtable<Archetype2, T>::get()->_index; }
+
+    template <typename T1, typename T2, R (*F)(T1 &, T2 &, Args...)>
+    static R _thunk(const first_view & a, const second_view & b, Args... args)
+    {
+      return F(*static_cast<T1 *>(access::obj(a)), *static_cast<T2 *>(access::obj(b)),
+               std::forward<Args>(args)...);
+    }
+
+    template <typename T1, typename T2, R (*F)(T1 &, T2 &, Args...)>
+    static R _swapped_thunk(const first_view & a, const second_view & b, Args... args)
+    {
+      return F(*static_cast<T1 *>(access::obj(b)), *static_cast<T2 *>(access::obj(a)),
+               std::forward<Args>(args)...);
+    }
+
+    static R _null_fallback(const first_view &, const second_view &, Args...)
+    {
+      return null_result<R>::get();
+    }
+
+    // Grows the table to hold (i, j), new cells go to the fallback
+    void _set(std::size_t i, std::size_t j, handler h)
+    {
+      if (i >= _rows || j >= _cols) {
+        std::size_t rows = i >= _rows ? i + 1 : _rows;
+        std::size_t cols = j >= _cols ? j + 1 : _cols;
+        std::vector<handler> table(rows * cols, _fallback);
+        for (std::size_t r = 0; r < _rows; r++) {
+          for (std::size_t c = 0; c < _cols; c++) {
+            table[r * cols + c] = _table[r * _cols + c];
+          }
+        }
+        _table.swap(table);
+        _rows = rows;
+        _cols = cols;
+      }
+      _table[i * _cols + j] = h;
+    }
+
+    handler _fallback;
+    std::size_t _rows;
+    std::size_t _cols;
+    std::vector<handler> _table;
+  };
+
+} // namespace archetype
+
+#endif //__ARCHETYPE_MULTI_DISPATCH_H__
@@ -0,0 +1,243 @@
+#ifndef __ARCHETYPE_MULTICAST_H__
+#define __ARCHETYPE_MULTICAST_H__
+
+#include "archetype/archetype.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace archetype {
+
+  // Policies for combining the results of the subscribers of a multicast.
+  // Methods returning void just call every subscriber. With no subscribers
+  // the null vtable result is returned.
+
+  // Result of the last subscriber called
+  struct last_result
+  {
+    template <typename R>
+    struct combiner
+    {
+      combiner() : _r(null_result<R>::get()) {}
+      void add(R r) { _r = r; }
+      R get() { return _r; }
+      R _r;
+    };
+
+    template <typename R>
+    struct combiner<R &>
+    {
+      combiner() : _r(&null_result<R &>::get()) {}
+      void add(R & r) { _r = &r; }
+      R & get() { return *_r; }
+      R * _r;
+    };
+  };
+
+  // Sum of the results
+  struct sum_results
+  {
+    template <typename R>
+    struct combiner
+    {
+      combiner() : _r() {}
+      void add(R r) { _r = _r + r; }
+      R get() { return _r; }
+      R _r;
+    };
+  };
+
+  // true if every subscriber returned true, and with no subscribers
+  struct all_results
+  {
+    template <typename R>
+    struct combiner
+    {
+      combiner() : _r(true) {}
+      void add(R r) { _r = _r && r; }
+      R get() { return _r; }
+      R _r;
+    };
+  };
+
+  // true if any subscriber returned true
+  struct any_result
+  {
+    template <typename R>
+    struct combiner
+    {
+      combiner() : _r(false) {}
+      void add(R r) { _r = _r || r; }
+      R get() { return _r; }
+      R _r;
+    };
+  };
+
+  template <typename R, typename Combine>
+  struct multicast_call
+  {
+    template <typename Method, typename View, typename... Args>
+    static R call(View * first, View * last, Args &... args)
+    {
+      typename Combine::template combiner<R> c;
+      for (; first != last; ++first) {
+        c.add(Method::template _call<View>(first, args...));
+      }
+      return c.get();
+    }
+  };
+
+  template <typename Combine>
+  struct multicast_call<void, Combine>
+  {
+    template <typename Method, typename View, typename... Args>
+    static void call(View * first, View * last, Args &... args)
+    {
+      for (; first != last; ++first) {
+        Method::template _call<View>(first, args...);
+      }
+    }
+  };
+
+  template <class Archetype, typename Combine>
+  class multicast_base
+  {
+    public:
+    template <typename R>
+    struct result { using type = R; };
+
+    protected:
+    using view = typename Archetype::view;
+
+    // Immutable snapshot of the subscribers, sorted by vtable so views
+    // bound to the same type are called back to back
+    struct subscribers
+    {
+      std::vector<view> views;
+    };
+
+    multicast_base() : _list(new subscribers()), _epoch(0)
+    {
+      _readers[0].store(0);
+      _readers[1].store(0);
+    }
+
+    ~multicast_base() { delete _list.load(); }
+
+    multicast_base(const multicast_base &) = delete;
+    multicast_base & operator=(const multicast_base &) = delete;
+
+    // Arguments are passed to every subscriber as lvalues, so none of them
+    // can be moved from before the last subscriber is called
+    template <typename R, typename Method, typename... Args>
+    R _forward(Args &&... args)
+    {
+      // Readers register with the current epoch, writers wait for the
+      // readers of the previous epoch before freeing the old snapshot
+      std::size_t epoch;
+      for (;;) {
+        epoch = _epoch.load();
+        _readers[epoch & 1].fetch_add(1);
+        if (_epoch.load() == epoch) { break; }
+        _readers[epoch & 1].fetch_sub(1);
+      }
+
+      struct leave
+      {
+        std::atomic<std::size_t> & readers;
+        ~leave() { readers.fetch_sub(1, std::memory_order_release); }
+      } guard{_readers[epoch & 1]};
+
+      subscribers * list = _list.load(std::memory_order_acquire);
+      view * first = list->views.data();
+      return multicast_call<R, Combine>::template call<Method>(
+          first, first + list->views.size(), args...);
+    }
+
+    template <typename Edit>
+    void _update(Edit edit)
+    {
+      std::lock_guard<std::mutex> lock(_writer);
+      subscribers * old = _list.load(std::memory_order_relaxed);
+      subscribers * next = new subscribers(*old);
+      edit(next->views);
+      std::stable_sort(next->views.begin(), next->views.end(),
+                       [](const view & a, const view & b) {
+                         return std::less<const void *>()(access::vtbl(a),
+                                                          access::vtbl(b));
+                       });
+      _list.store(next);
+
+      std::size_t epoch = _epoch.load();
+      _epoch.store(epoch + 1);
+      while (_readers[epoch & 1].load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+      }
+      delete old;
+    }
+
+    static bool _same(const view & a, const view & b)
+    {
+      return access::obj(a) == access::obj(b) && access::vtbl(a) == access::vtbl(b);
+    }
+
+    std::atomic<subscribers *> _list;
+    std::atomic<std::size_t> _epoch;
+    std::atomic<std::size_t> _readers[2];
+    mutable std::mutex _writer;
+  };
+
+  // Calls every subscriber for each method of Archetype. Publishing never
+  // locks, subscribing copies the subscriber array and waits for in flight
+  // publishes before freeing the old one. Subscribers are called grouped by
+  // bound type, not in subscription order. Combine picks the return value.
+  // Subscribers must not subscribe or unsubscribe from inside a call, as
+  // the update would wait for the call to finish.
+  template <class Archetype, typename Combine = last_result>
+  class multicast
+      : public helper<Archetype>::template forward_layer<
+            multicast_base<Archetype, Combine>>
+  {
+    using view = typename Archetype::view;
+
+    public:
+    multicast() {}
+
+    void subscribe(const view & v)
+    {
+      this->_update([&](std::vector<view> & views) { views.push_back(v); });
+    }
+
+    template <typename T, typename = typename std::enable_if<
+                              !std::is_base_of<view, T>::value>::type>
+    void subscribe(T & t) { subscribe(view(t)); }
+
+    // Removes every subscription with the same binding as v
+    void unsubscribe(const view & v)
+    {
+      this->_update([&](std::vector<view> & views) {
+        views.erase(std::remove_if(views.begin(), views.end(),
+                                   [&](const view & s) { return this->_same(s, v); }),
+                    views.end());
+      });
+    }
+
+    template <typename T, typename = typename std::enable_if<
+                              !std::is_base_of<view, T>::value>::type>
+    void unsubscribe(T & t) { unsubscribe(view(t)); }
+
+    std::size_t size() const
+    {
+      std::lock_guard<std::mutex> lock(this->_writer);
+      return this->_list.load()->views.size();
+    }
+  };
+
+} // namespace archetype
+
+#endif //__ARCHETYPE_MULTICAST_H__
@@ -0,0 +1,242 @@
+#ifndef __ARCHETYPE_PARALLEL_H__
+#define __ARCHETYPE_PARALLEL_H__
+
+#include "archetype/archetype.h"
+#include "archetype/compact.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace archetype {
+
+  // Fixed size thread pool running batches of indexed tasks. Each worker
+  // owns a deque of task indices, pops from its back, and steals from the
+  // front of the others when it runs dry. The calling thread takes part as
+  // worker 0. Tasks must not throw.
+  class work_stealing_pool
+  {
+    public:
+    explicit work_stealing_pool(unsigned threads = std::thread::hardware_concurrency())
+        : _job(nullptr), _ctx(nullptr), _generation(0), _remaining(0),
+          _active(0), _stop(false)
+    {
+      if (threads == 0) { threads = 1; }
+      for (unsigned i = 0; i < threads; i++) {
+        _queues.emplace_back(new queue());
+      }
+      for (unsigned i = 1; i < threads; i++) {
+        _threads.emplace_back(&work_stealing_pool::_worker, this, i);
+      }
+    }
+
+    ~work_stealing_pool()
+    {
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+      }
+      _wake.notify_all();
+      for (auto & t : _threads) { t.join(); }
+    }
+
+    work_stealing_pool(const work_stealing_pool &) = delete;
+    work_stealing_pool & operator=(const work_stealing_pool &) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(_queues.size()); }
+
+    // Calls f(i) for every i in [0, n) and returns once all calls are done.
+    // Indices are dealt to workers in contiguous blocks.
+    template <typename F>
+    void run(std::size_t n, F f)
+    {
+      if (n == 0) { return; }
+      const std::size_t workers = _queues.size();
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _job = &_invoke<F>;
+        _ctx = &f;
+        for (std::size_t w = 0; w < workers; w++) {
+          std::lock_guard<std::mutex> qlock(_queues[w]->mutex);
+          for (std::size_t i = n * w / workers; i < n * (w + 1) / workers; i++) {
+            _queues[w]->tasks.push_back(i);
+          }
+        }
+        _remaining.store(n, std::memory_order_relaxed);
+        _active = workers - 1;
+        _generation++;
+      }
+      _wake.notify_all();
+
+      _work(0);
+
+      // workers leave the batch before the job it points to goes out of scope
+      std::unique_lock<std::mutex> lock(_mutex);
+      _done.wait(lock, [this] { return _active == 0; });
+    }
+
+    private:
+    struct queue
+    {
+      std::mutex mutex;
+      std::deque<std::size_t> tasks;
+    };
+
+    template <typename F>
+    static void _invoke(void * ctx, std::size_t i) { (*static_cast<F *>(ctx))(i); }
+
+    bool _pop(std::size_t w, std::size_t & task)
+    {
+      queue & q = *_queues[w];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (q.tasks.empty()) { return false; }
+      task = q.tasks.back();
+      q.tasks.pop_back();
+      return true;
+    }
+
+    bool _steal(std::size_t w, std::size_t & task)
+    {
+      const std::size_t workers = _queues.size();
+      for (std::size_t k = 1; k < workers; k++) {
+        queue & q = *_queues[(w + k) % workers];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (!q.tasks.empty()) {
+          task = q.tasks.front();
+          q.tasks.pop_front();
+          return true;
+        }
+      }
+      return false;
+    }
+
+    void _work(std::size_t w)
+    {
+      std::size_t task;
+      while (_remaining.load(std::memory_order_acquire) != 0) {
+        if (_pop(w, task) || _steal(w, task)) {
+          _job(_ctx, task);
+          _remaining.fetch_sub(1, std::memory_order_acq_rel);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    }
+
+    void _worker(std::size_t w)
+    {
+      std::size_t seen = 0;
+      for (;;) {
+        {
+          std::unique_lock<std::mutex> lock(_mutex);
+          _wake.wait(lock, [&] { return _stop || _generation != seen; });
+          if (_stop) { return; }
+          seen = _generation;
+        }
+        _work(w);
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          if (--_active == 0) { _done.notify_one(); }
+        }
+      }
+    }
+
+    std::vector<std::unique_ptr<queue>> _queues;
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    void (*_job)(void *, std::size_t);
+    void * _ctx;
+    std::size_t _generation;
+    std::atomic<std::size_t> _remaining;
+    std::size_t _active;
+    bool _stop;
+  };
+
+  // Positions of a collection ordered by vtable index, split into chunks
+  // that never span two bound types.
+  class type_chunks
+  {
+    public:
+    template <typename IndexOf>
+    type_chunks(std::size_t n, IndexOf index_of, std::size_t chunk_size)
+    {
+      if (chunk_size == 0) { chunk_size = 1; }
+
+      // counting sort by vtable index, stable within a type
+      std::vector<std::size_t> types(n);
+      std::size_t most = 0;
+      for (std::size_t i = 0; i < n; i++) {
+        types[i] = index_of(i);
+        if (types[i] > most) { most = types[i]; }
+      }
+      std::vector<std::size_t> counts(most + 2, 0);
+      for (std::size_t i = 0; i < n; i++) { counts[types[i] + 1]++; }
+      for (std::size_t t = 1; t < counts.size(); t++) { counts[t] += counts[t - 1]; }
+
+      std::vector<std::size_t> next(counts.begin(), counts.end() - 1);
+      _order.resize(n);
+      for (std::size_t i = 0; i < n; i++) { _order[next[types[i]]++] = i; }
+
+      for (std::size_t t = 0; t + 1 < counts.size(); t++) {
+        for (std::size_t b = counts[t]; b < counts[t + 1]; b += chunk_size) {
+          _bounds.push_back(b);
+        }
+      }
+      _bounds.push_back(n);
+    }
+
+    std::size_t size() const { return _bounds.size() - 1; }
+
+    // Calls f(position) for each position in chunk c
+    template <typename F>
+    void for_each_in(std::size_t c, F & f) const
+    {
+      for (std::size_t k = _bounds[c]; k < _bounds[c + 1]; k++) { f(_order[k]); }
+    }
+
+    private:
+    std::vector<std::size_t> _order;
+    std::vector<std::size_t> _bounds;
+  };
+
+  // Vtable index of an erased view, held by the vtable itself
+  template <typename VTableType>
+  unsigned short _vtable_index(const view_base<VTableType> & v)
+  {
+    return access::vtbl(v)->_index;
+  }
+
+  // Calls f(view) for every element of a view_array across the pool. Each
+  // chunk holds at most chunk_size views bound to the same type.
+  template <class Archetype, typename F>
+  void parallel_for_each(work_stealing_pool & pool,
+                         const view_array<Archetype> & views, F f,
+                         std::size_t chunk_size = 1024)
+  {
+    type_chunks chunks(
+        views.size(), [&](std::size_t i) { return views.index(i); }, chunk_size);
+    auto call = [&](std::size_t i) { f(views[i]); };
+    pool.run(chunks.size(), [&](std::size_t c) { chunks.for_each_in(c, call); });
+  }
+
+  // Random access range of archetype views
+  template <typename Iterator, typename F>
+  void parallel_for_each(work_stealing_pool & pool, Iterator first,
+                         Iterator last, F f, std::size_t chunk_size = 1024)
+  {
+    type_chunks chunks(
+        static_cast<std::size_t>(last - first),
+        [&](std::size_t i) { return _vtable_index(*(first + i)); }, chunk_size);
+    auto call = [&](std::size_t i) { f(*(first + i)); };
+    pool.run(chunks.size(), [&](std::size_t c) { chunks.for_each_in(c, call); });
+  }
+
+} // namespace archetype
+
+#endif //__ARCHETYPE_PARALLEL_H__
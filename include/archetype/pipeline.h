@@ -0,0 +1,293 @@
+#ifndef __ARCHETYPE_PIPELINE_H__
+#define __ARCHETYPE_PIPELINE_H__
+
+#include "archetype/archetype.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace archetype {
+
+  // A view of bytes in a reference counted block. Copying a slice, or
+  // taking a sub slice, shares the block instead of copying the bytes.
+  class buffer_slice
+  {
+    public:
+    buffer_slice() : _block(nullptr), _data(nullptr), _size(0) {}
+
+    // A slice of a new block of n bytes, writable until it is shared
+    static buffer_slice allocate(std::size_t n)
+    {
+      void * p = ::operator new(sizeof(block) + n);
+      block * b = new (p) block();
+      b->refs.store(1, std::memory_order_relaxed);
+      return buffer_slice(b, reinterpret_cast<char *>(b + 1), n);
+    }
+
+    // A slice of bytes owned by the caller, which must outlive every copy
+    static buffer_slice borrow(const char * data, std::size_t n)
+    {
+      return buffer_slice(nullptr, data, n);
+    }
+
+    buffer_slice(const buffer_slice & other)
+        : _block(other._block), _data(other._data), _size(other._size)
+    {
+      if (_block) { _block->refs.fetch_add(1, std::memory_order_relaxed); }
+    }
+
+    buffer_slice(buffer_slice && other)
+        : _block(other._block), _data(other._data), _size(other._size)
+    {
+      other._block = nullptr;
+      other._data = nullptr;
+      other._size = 0;
+    }
+
+    buffer_slice & operator=(buffer_slice other)
+    {
+      std::swap(_block, other._block);
+      std::swap(_data, other._data);
+      std::swap(_size, other._size);
+      return *this;
+    }
+
+    ~buffer_slice()
+    {
+      if (_block && _block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        _block->~block();
+        ::operator delete(_block);
+      }
+    }
+
+    const char * data() const { return _data; }
+    std::size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    // Writable bytes while this is the only reference to an allocated
+    // block, otherwise nullptr
+    char * mutable_data()
+    {
+      return _block && _block->refs.load(std::memory_order_acquire) == 1
+                 ? const_cast<char *>(_data)
+                 : nullptr;
+    }
+
+    // n bytes from offset, sharing the block
+    buffer_slice slice(std::size_t offset, std::size_t n) const
+    {
+      if (_block) { _block->refs.fetch_add(1, std::memory_order_relaxed); }
+      return buffer_slice(_block, _data + offset, n);
+    }
+
+    private:
+    struct block
+    {
+      std::atomic<std::size_t> refs;
+    };
+
+    buffer_slice(block * b, const char * data, std::size_t size)
+        : _block(b), _data(data), _size(size) {}
+
+    block * _block;
+    const char * _data;
+    std::size_t _size;
+  };
+
+  // Fixed capacity queue between two threads. push waits while the queue
+  // is full, which is the backpressure between pipeline stages.
+  template <typename T>
+  class bounded_queue
+  {
+    public:
+    explicit bounded_queue(std::size_t capacity)
+        : _items(capacity ? capacity : 1), _head(0), _count(0), _closed(false) {}
+
+    // Waits for room, false once the queue is closed
+    bool push(T t)
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _not_full.wait(lock, [&] { return _closed || _count < _items.size(); });
+      if (_closed) { return false; }
+      _items[(_head + _count) % _items.size()] = std::move(t);
+      _count++;
+      _not_empty.notify_one();
+      return true;
+    }
+
+    // Waits for an item, false once the queue is closed and empty
+    bool pop(T & t)
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _not_empty.wait(lock, [&] { return _closed || _count > 0; });
+      if (_count == 0) { return false; }
+      t = std::move(_items[_head]);
+      _head = (_head + 1) % _items.size();
+      _count--;
+      _not_full.notify_one();
+      return true;
+    }
+
+    // Wakes both sides. Items already queued can still be popped.
+    void close()
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _closed = true;
+      _not_full.notify_all();
+      _not_empty.notify_all();
+    }
+
+    private:
+    std::vector<T> _items;
+    std::size_t _head;
+    std::size_t _count;
+    bool _closed;
+    std::mutex _mutex;
+    std::condition_variable _not_full;
+    std::condition_variable _not_empty;
+  };
+
+  // Produces the slices of a stream, false at the end of it
+  ARCHETYPE_DEFINE(slice_source, (ARCHETYPE_METHOD(bool, next, buffer_slice &)))
+
+  // Consumes slices, false to stop the stream
+  ARCHETYPE_DEFINE(slice_sink, (ARCHETYPE_METHOD(bool, push, const buffer_slice &)))
+
+  // Pushes zero or more slices to out for each slice in, usually sub slices
+  // of it. false stops the stream.
+  ARCHETYPE_DEFINE(slice_stage, (ARCHETYPE_METHOD(bool, process, const buffer_slice &,
+                                                  slice_sink::view &)))
+
+  // A chain of stages between a source and a sink. Slices move between
+  // stages by reference, not by copying their bytes. A threaded stage runs
+  // on its own thread, fed by a bounded queue from the stage before it,
+  // other stages run on the thread of the stage before them.
+  class pipeline
+  {
+    public:
+    explicit pipeline(std::size_t queue_capacity = 16)
+        : _queue_capacity(queue_capacity) {}
+
+    pipeline & then(slice_stage::view stage)
+    {
+      _stages.push_back(entry{stage, false});
+      return *this;
+    }
+
+    pipeline & then_threaded(slice_stage::view stage)
+    {
+      _stages.push_back(entry{stage, true});
+      return *this;
+    }
+
+    // Moves every slice of source through the stages into sink. Returns
+    // false if a stage or the sink stopped the stream.
+    bool run(slice_source::view source, slice_sink::view sink)
+    {
+      std::size_t threaded = 0;
+      for (const entry & e : _stages) { threaded += e.threaded ? 1 : 0; }
+
+      // nodes are referenced by views, deques keep them in place
+      std::deque<stage_node> stages;
+      std::deque<queue_node> queues;
+      std::deque<bounded_queue<buffer_slice>> storage;
+      std::vector<slice_sink::view> consumers(threaded);
+
+      std::atomic<bool> stopped(false);
+      slice_sink::view next = sink;
+      for (std::size_t i = _stages.size(); i-- > 0;) {
+        stages.push_back(stage_node{_stages[i].stage, next});
+        next = slice_sink::view(stages.back());
+        if (_stages[i].threaded) {
+          storage.emplace_back(_queue_capacity);
+          queues.push_back(queue_node{&storage.back()});
+          consumers[storage.size() - 1] = next;
+          next = slice_sink::view(queues.back());
+        }
+      }
+
+      // queues were added back to front, queue k feeds consumers[k] and
+      // the thread draining it closes queue k - 1 when done
+      std::vector<std::thread> threads;
+      for (std::size_t k = 0; k < threaded; k++) {
+        threads.emplace_back([&, k] {
+          buffer_slice s;
+          while (storage[k].pop(s)) {
+            if (!consumers[k].push(s)) {
+              stopped = true;
+              storage[k].close();
+              break;
+            }
+          }
+          if (k > 0) { storage[k - 1].close(); }
+        });
+      }
+
+      buffer_slice s;
+      while (source.next(s)) {
+        if (!next.push(s)) {
+          stopped = true;
+          break;
+        }
+      }
+      if (threaded) { storage[threaded - 1].close(); }
+
+      for (std::size_t k = threaded; k-- > 0;) { threads[k].join(); }
+      return !stopped;
+    }
+
+    private:
+    struct entry
+    {
+      slice_stage::view stage;
+      bool threaded;
+    };
+
+    struct stage_node
+    {
+      slice_stage::view stage;
+      slice_sink::view next;
+      bool push(const buffer_slice & s) { return stage.process(s, next); }
+    };
+
+    struct queue_node
+    {
+      bounded_queue<buffer_slice> * queue;
+      bool push(const buffer_slice & s) { return queue->push(s); }
+    };
+
+    std::size_t _queue_capacity;
+    std::vector<entry> _stages;
+  };
+
+  // Source of fixed size sub slices of a single slice
+  class slice_chunks
+  {
+    public:
+    slice_chunks(buffer_slice whole, std::size_t chunk)
+        : _whole(std::move(whole)), _chunk(chunk), _offset(0) {}
+
+    bool next(buffer_slice & s)
+    {
+      if (_offset >= _whole.size()) { return false; }
+      std::size_t n = _whole.size() - _offset < _chunk ? _whole.size() - _offset : _chunk;
+      s = _whole.slice(_offset, n);
+      _offset += n;
+      return true;
+    }
+
+    private:
+    buffer_slice _whole;
+    std::size_t _chunk;
+    std::size_t _offset;
+  };
+
+} // namespace archetype
+
+#endif //__ARCHETYPE_PIPELINE_H__
@@ -0,0 +1,229 @@
+#ifndef __ARCHETYPE_RECORDER_H__
+#define __ARCHETYPE_RECORDER_H__
+
+#include "archetype/archetype.h"
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// Maximum number of distinct methods per archetype that can be recorded
+#ifndef ARCHETYPE_MAX_RECORDED_METHODS
+#define ARCHETYPE_MAX_RECORDED_METHODS 256
+#endif
+
+namespace archetype {
+
+  // Recorded calls, each a 2 byte method id followed by the raw bytes of its
+  // arguments. Method ids are assigned per archetype on first use, so a
+  // buffer is only meaningful within the process that recorded it.
+  class call_buffer
+  {
+    public:
+    call_buffer() : _archetype(nullptr) {}
+
+    const unsigned char * data() const { return _bytes.data(); }
+    std::size_t size() const { return _bytes.size(); }
+    bool empty() const { return _bytes.empty(); }
+    void clear() { _bytes.clear(); _archetype = nullptr; }
+
+    // Identity of the archetype the calls were recorded for, nullptr until
+    // the first call
+    const void * archetype() const { return _archetype; }
+
+    // Marks the calls as recorded for archetype. A buffer holds the calls of
+    // one archetype until it is cleared.
+    void set_archetype(const void * archetype)
+    {
+      require(!_archetype || _archetype == archetype,
+              "call_buffer holds calls of another archetype");
+      _archetype = archetype;
+    }
+    void reserve(std::size_t n) { _bytes.reserve(n); }
+
+    // Grows the buffer by n bytes and returns the start of them
+    unsigned char * extend(std::size_t n)
+    {
+      std::size_t at = _bytes.size();
+      _bytes.resize(at + n);
+      return &_bytes[at];
+    }
+
+    void append(const void * p, std::size_t n)
+    {
+      std::memcpy(extend(n), p, n);
+    }
+
+    private:
+    std::vector<unsigned char> _bytes;
+    const void * _archetype;
+  };
+
+  // Byte offset of argument I when Args are packed back to back
+  template <std::size_t I, typename... Args>
+  struct packed_offset;
+
+  template <typename A, typename... Args>
+  struct packed_offset<0, A, Args...> : std::integral_constant<std::size_t, 0> {};
+
+  template <std::size_t I, typename A, typename... Args>
+  struct packed_offset<I, A, Args...>
+      : std::integral_constant<std::size_t,
+                               sizeof(A) + packed_offset<I - 1, Args...>::value> {};
+
+  template <typename T>
+  T unpack(const unsigned char * p)
+  {
+    T t;
+    std::memcpy(&t, p, sizeof(T));
+    return t;
+  }
+
+  // Replay thunks of the recorded methods of one archetype, indexed by id.
+  // Keyed by vtable type so replay can find it from any view.
+  template <typename VTableType>
+  struct call_table
+  {
+    // Calls a method on the binding with the arguments at args, returns
+    // their size
+    using thunk = std::size_t (*)(const unsigned char * args, void * obj,
+                                  const VTableType * vtbl);
+
+    template <class Archetype, typename Method, typename... Args>
+    static unsigned short id()
+    {
+      static const unsigned short index =
+          _add(&_replay<typename Archetype::view, Method, Args...>);
+      return index;
+    }
+
+    static thunk get(unsigned short id) {
+      return _thunks[id].load(std::memory_order_acquire);
+    }
+
+    // Identity of the archetype stored in the buffers it records
+    static const void * identity() { return &_next; }
+
+    template <typename View, typename Method, typename... Args>
+    static std::size_t _replay(const unsigned char * args, void * obj,
+                               const VTableType * vtbl)
+    {
+      View v = access::make<View>(obj, vtbl);
+      _call<Method, Args...>(args, v, typename make_indices<sizeof...(Args)>::type());
+      return packed_offset<sizeof...(Args), Args..., char>::value;
+    }
+
+    template <typename Method, typename... Args, typename View, std::size_t... Is>
+    static void _call(const unsigned char * args, View & v, indices<Is...>)
+    {
+      (void)args;
+      Method::template _call<View>(
+          &v, unpack<Args>(args + packed_offset<Is, Args...>::value)...);
+    }
+
+    static unsigned short _add(thunk t)
+    {
+      unsigned index = _next.fetch_add(1, std::memory_order_relaxed);
+      require(index < ARCHETYPE_MAX_RECORDED_METHODS,
+              "too many methods, increase ARCHETYPE_MAX_RECORDED_METHODS");
+      _thunks[index].store(t, std::memory_order_release);
+      return static_cast<unsigned short>(index);
+    }
+
+    static std::atomic<thunk> _thunks[ARCHETYPE_MAX_RECORDED_METHODS];
+    static std::atomic<unsigned> _next;
+  };
+
+  template <typename VTableType>
+  std::atomic<typename call_table<VTableType>::thunk>
+      call_table<VTableType>::_thunks[ARCHETYPE_MAX_RECORDED_METHODS];
+
+  template <typename VTableType>
+  std::atomic<unsigned> call_table<VTableType>::_next(0);
+
+  // Whether a parameter can be recorded. Its argument is copied byte for
+  // byte and replayed later, possibly on another thread, so pointers could
+  // dangle and writes through a non const reference would go to the copy.
+  template <typename T>
+  struct recorded_parameter
+      : std::integral_constant<
+            bool, !std::is_pointer<typename std::decay<T>::type>::value &&
+                      !(std::is_lvalue_reference<T>::value &&
+                        !std::is_const<typename std::remove_reference<T>::type>::value)> {};
+
+  template <typename Signature> struct recorded_signature;
+
+  template <typename R, typename... Params>
+  struct recorded_signature<R(Params...)>
+      : all_of<recorded_parameter<Params>::value...> {};
+
+  template <class Archetype>
+  class recorder_base
+  {
+    public:
+    template <typename R>
+    struct result { using type = R; };
+
+    protected:
+    using table = call_table<typename helper<Archetype>::template vtable<>>;
+
+    template <typename R, typename Method, typename... Args>
+    R _forward(Args... args)
+    {
+      static_assert(all_of<std::is_trivially_copyable<Args>::value...>::value,
+                    "recorded arguments must be trivially copyable");
+      static_assert(recorded_signature<typename Method::_signature>::value,
+                    "recorded calls copy their arguments, so parameters can't be "
+                    "pointers or non const references");
+      unsigned short id = table::template id<Archetype, Method, Args...>();
+      _buffer->set_archetype(table::identity());
+      unsigned char * p = _buffer->extend(
+          sizeof(id) + packed_offset<sizeof...(Args), Args..., char>::value);
+      std::memcpy(p, &id, sizeof(id));
+      p += sizeof(id);
+      int expand[] = {0, (std::memcpy(p, &args, sizeof(args)), p += sizeof(args), 0)...};
+      (void)expand;
+      return null_result<R>::get();
+    }
+
+    call_buffer * _buffer;
+  };
+
+  // Implements the methods of Archetype by appending each call to a
+  // call_buffer. Methods return the null vtable result, so a recorder can
+  // itself be bound to Archetype::view. Arguments are recorded by value, so
+  // methods taking pointers, const char * included, or non const references
+  // are rejected at compile time rather than recorded as addresses.
+  template <class Archetype>
+  class recorder
+      : public helper<Archetype>::template forward_layer<recorder_base<Archetype>>
+  {
+    public:
+    explicit recorder(call_buffer & buffer) { this->_buffer = &buffer; }
+  };
+
+  // Replays every call in buffer against the binding of v, in recorded
+  // order. Returns false without replaying if the calls were recorded for
+  // another archetype.
+  template <typename VTableType>
+  bool replay(const call_buffer & buffer, const view_base<VTableType> & v)
+  {
+    if (!buffer.empty() && buffer.archetype() != call_table<VTableType>::identity()) {
+      return false;
+    }
+    void * obj = access::obj(v);
+    const VTableType * vtbl = access::vtbl(v);
+    const unsigned char * p = buffer.data();
+    const unsigned char * end = p + buffer.size();
+    while (p < end) {
+      unsigned short id = unpack<unsigned short>(p);
+      p += sizeof(id);
+      p += call_table<VTableType>::get(id)(p, obj, vtbl);
+    }
+    return true;
+  }
+
+} // namespace archetype
+
+#endif //__ARCHETYPE_RECORDER_H__
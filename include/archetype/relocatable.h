@@ -0,0 +1,156 @@
+#ifndef __ARCHETYPE_RELOCATABLE_H__
+#define __ARCHETYPE_RELOCATABLE_H__
+
+#include "archetype/archetype.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+// Number of type ids per archetype usable by relocatable views, ids are
+// from 1 to ARCHETYPE_MAX_RELOCATABLE_TYPES - 1
+#ifndef ARCHETYPE_MAX_RELOCATABLE_TYPES
+#define ARCHETYPE_MAX_RELOCATABLE_TYPES 256
+#endif
+
+namespace archetype {
+
+  // Per process mapping between stable type ids, chosen by the program, and
+  // the vtables of one archetype. Every process using a relocatable view
+  // registers the same id for the same type, usually at startup, before
+  // views are resolved.
+  template <class Archetype>
+  struct relocatable_types
+  {
+    using vtable_type = typename helper<Archetype>::template vtable<>;
+
+    template <typename T>
+    static void add(std::uint32_t id)
+    {
+      static_assert(Archetype::template check<T>::value,
+                    "T must satisfy Archetype::check");
+      require(id != 0 && id < ARCHETYPE_MAX_RELOCATABLE_TYPES, "relocatable type id out of range");
+      _table[id].store(bound_vtable<Archetype, T>::get(), std::memory_order_release);
+      _id_of<T>().store(id, std::memory_order_release);
+    }
+
+    // Id registered for T, 0 if there is none
+    template <typename T>
+    static std::uint32_t id() { return _id_of<T>().load(std::memory_order_acquire); }
+
+    // Vtable registered for id, the null vtable if there is none
+    static const vtable_type * get(std::uint32_t id)
+    {
+      const vtable_type * vtbl = id < ARCHETYPE_MAX_RELOCATABLE_TYPES
+                                     ? _table[id].load(std::memory_order_acquire)
+                                     : nullptr;
+      return vtbl ? vtbl : vtable_type::make_null_vtable();
+    }
+
+    private:
+    template <typename T>
+    static std::atomic<std::uint32_t> & _id_of()
+    {
+      static std::atomic<std::uint32_t> id(0);
+      return id;
+    }
+
+    static std::atomic<const vtable_type *> _table[ARCHETYPE_MAX_RELOCATABLE_TYPES];
+  };
+
+  template <class Archetype>
+  std::atomic<const typename relocatable_types<Archetype>::vtable_type *>
+      relocatable_types<Archetype>::_table[ARCHETYPE_MAX_RELOCATABLE_TYPES];
+
+  template <class Archetype>
+  class relocatable_view_base
+  {
+    public:
+    template <typename R>
+    struct result { using type = R; };
+
+    protected:
+    using view = typename Archetype::view;
+
+    relocatable_view_base() : _offset(0), _id(0) {}
+
+    void * _target() const
+    {
+      return _id ? const_cast<char *>(reinterpret_cast<const char *>(this)) + _offset : nullptr;
+    }
+
+    void _set(void * obj, std::uint32_t id)
+    {
+      _offset = obj ? reinterpret_cast<char *>(obj) - reinterpret_cast<char *>(this) : 0;
+      _id = obj ? id : 0;
+    }
+
+    view _resolve() const
+    {
+      return access::make<view>(_target(), relocatable_types<Archetype>::get(_id));
+    }
+
+    // Calls are synchronous, so arguments are passed on by reference
+    template <typename R, typename Method, typename... Args>
+    R _forward(Args &&... args)
+    {
+      view v = _resolve();
+      return Method::template _call<view>(&v, std::forward<Args>(args)...);
+    }
+
+    std::int64_t _offset;
+    std::uint32_t _id;
+  };
+
+  // A view that can live in shared memory or a mapped file. It holds the
+  // object's offset from the view itself and the object's type id, so it
+  // stays valid when the memory holding both is mapped at another address
+  // or by another process, which resolves the id through its own
+  // relocatable_types. The object must be in the same mapping, and be
+  // relocatable itself. Copying a relocatable view points the copy at the
+  // same object.
+  template <class Archetype>
+  class relocatable_view
+      : public helper<Archetype>::template forward_layer<relocatable_view_base<Archetype>>
+  {
+    using view = typename Archetype::view;
+
+    public:
+    relocatable_view() {}
+
+    template <typename T, typename = typename std::enable_if<
+                              !std::is_base_of<relocatable_view, T>::value>::type>
+    relocatable_view(T & t) { bind(t); }
+
+    relocatable_view(const relocatable_view & other) { this->_set(other._target(), other._id); }
+
+    relocatable_view & operator=(const relocatable_view & other)
+    {
+      this->_set(other._target(), other._id);
+      return *this;
+    }
+
+    // T must have been added to relocatable_types<Archetype>, binding any
+    // other type aborts
+    template <typename T>
+    void bind(T & t)
+    {
+      std::uint32_t id = relocatable_types<Archetype>::template id<T>();
+      require(id != 0, "type not added to relocatable_types");
+      this->_set(&t, id);
+    }
+
+    void reset() { this->_set(nullptr, 0); }
+
+    // A process local view of the object
+    view get() const { return this->_resolve(); }
+
+    std::uint32_t type_id() const { return this->_id; }
+
+    explicit operator bool() const { return this->_id != 0; }
+  };
+
+} // namespace archetype
+
+#endif //__ARCHETYPE_RELOCATABLE_H__
@@ -0,0 +1,335 @@
+#ifndef __ARCHETYPE_SCHEDULER_H__
+#define __ARCHETYPE_SCHEDULER_H__
+
+#include "archetype/archetype.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Bytes available to a task object in a scheduler slot
+#ifndef ARCHETYPE_TASK_SIZE
+#define ARCHETYPE_TASK_SIZE 64
+#endif
+
+namespace archetype {
+
+  ARCHETYPE_DEFINE(runnable, (ARCHETYPE_METHOD(void, run)))
+
+  // Work stealing scheduler whose tasks are runnable objects. Tasks are
+  // copied into fixed size slots owned by a worker, allocated when the
+  // scheduler is built, and run through a runnable::view, so submitting
+  // never allocates. Each worker owns a queue of ready tasks, pops from its
+  // back, and steals from the front of the others when it runs dry. Tasks
+  // submitted from a worker go to that worker, others are dealt round
+  // robin. Tasks must not throw.
+  class task_scheduler
+  {
+    public:
+    explicit task_scheduler(unsigned threads = std::thread::hardware_concurrency(),
+                            std::size_t slots_per_worker = 1024)
+        : _round_robin(0), _queued(0), _pending(0), _sleepers(0), _stop(false)
+    {
+      if (threads == 0) { threads = 1; }
+      std::size_t slots = 2;
+      while (slots < slots_per_worker) { slots *= 2; }
+      for (unsigned i = 0; i < threads; i++) {
+        _workers.emplace_back(new worker(i, slots));
+      }
+      for (unsigned i = 0; i < threads; i++) {
+        _threads.emplace_back(&task_scheduler::_worker_loop, this, i);
+      }
+    }
+
+    // Runs every submitted task before stopping the workers
+    ~task_scheduler()
+    {
+      wait();
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+      }
+      _wake.notify_all();
+      for (auto & t : _threads) { t.join(); }
+    }
+
+    task_scheduler(const task_scheduler &) = delete;
+    task_scheduler & operator=(const task_scheduler &) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(_workers.size()); }
+
+    // Queues a copy of task. While every slot of the chosen worker is in
+    // use, runs queued tasks to free one, and if none are queued, takes a
+    // slot of another worker. With every slot held by a running task, as
+    // when tasks wait on the tasks they submit, task runs right away.
+    template <typename T>
+    void submit(T task)
+    {
+      _check<T>();
+      slot * s = _acquire(_choose());
+      if (!s) {
+        task.run();
+        return;
+      }
+      _fill(s, std::move(task));
+      _pending.fetch_add(1, std::memory_order_relaxed);
+      _push(s);
+    }
+
+    // Queues first, and each of rest once the task before it has run. If
+    // slots for the whole chain can't be had, it runs right away, in order.
+    template <typename T, typename... Ts>
+    void submit_chain(T first, Ts... rest)
+    {
+      int checked[] = {(_check<T>(), 0), (_check<Ts>(), 0)...};
+      (void)checked;
+      const std::size_t n = 1 + sizeof...(Ts);
+      worker & w = _choose();
+      slot * slots[n];
+      for (std::size_t i = 0; i < n; i++) {
+        if (!(slots[i] = _acquire(w))) {
+          while (i-- > 0) { _release(slots[i]); }
+          int ran[] = {(first.run(), 0), (rest.run(), 0)...};
+          (void)ran;
+          return;
+        }
+      }
+      _fill_chain(slots, std::move(first), std::move(rest)...);
+      _pending.fetch_add(n, std::memory_order_relaxed);
+      _push(slots[0]);
+    }
+
+    // Runs queued tasks on the calling thread until every submitted task,
+    // and every task they submitted, has run. The running task counts as
+    // pending, so calling it from a task of this scheduler aborts rather
+    // than spinning forever.
+    void wait()
+    {
+      require(!_current(), "task_scheduler::wait called from one of its tasks");
+      while (_pending.load(std::memory_order_acquire) != 0) {
+        if (!_run_one(0)) { std::this_thread::yield(); }
+      }
+    }
+
+    private:
+    struct slot
+    {
+      std::size_t owner;
+      runnable::view task;
+      void (*destroy)(void *);
+      slot * next;
+      alignas(std::max_align_t) unsigned char data[ARCHETYPE_TASK_SIZE];
+
+      slot() : owner(0), destroy(nullptr), next(nullptr) {}
+    };
+
+    // Slots, a stack of the free ones, and the ring of ready tasks, which
+    // can hold every slot
+    struct worker
+    {
+      worker(std::size_t index, std::size_t size)
+          : slots(size), free(size), free_count(size), ready(size), mask(size - 1),
+            head(0), count(0)
+      {
+        for (std::size_t i = 0; i < size; i++) {
+          slots[i].owner = index;
+          free[i] = &slots[i];
+        }
+      }
+
+      std::mutex mutex;
+      std::vector<slot> slots;
+      std::vector<slot *> free;
+      std::size_t free_count;
+      std::vector<slot *> ready;
+      std::size_t mask;
+      std::size_t head;
+      std::size_t count;
+    };
+
+    template <typename T>
+    static void _destroy(void * data) { static_cast<T *>(data)->~T(); }
+
+    // The scheduler and worker index of the calling thread, if it is a
+    // worker
+    struct current_worker
+    {
+      const task_scheduler * scheduler;
+      std::size_t index;
+    };
+
+    static current_worker & _current_worker()
+    {
+      static thread_local current_worker current = {nullptr, 0};
+      return current;
+    }
+
+    bool _current() const { return _current_worker().scheduler == this; }
+
+    std::size_t _current_index() const { return _current() ? _current_worker().index : 0; }
+
+    worker & _choose()
+    {
+      if (_current()) { return *_workers[_current_worker().index]; }
+      std::size_t i = _round_robin.fetch_add(1, std::memory_order_relaxed);
+      return *_workers[i % _workers.size()];
+    }
+
+    template <typename T>
+    static void _check()
+    {
+      static_assert(runnable::check<T>::value, "tasks must satisfy runnable::check");
+      static_assert(sizeof(T) <= ARCHETYPE_TASK_SIZE,
+                    "task too large, increase ARCHETYPE_TASK_SIZE");
+      static_assert(alignof(T) <= alignof(std::max_align_t), "task alignment not supported");
+    }
+
+    // A free slot, preferably of w, or nullptr if every slot is held by a
+    // running task
+    slot * _acquire(worker & w)
+    {
+      for (;;) {
+        if (slot * s = _allocate(w)) { return s; }
+        if (_run_one(_current_index())) { continue; }
+        for (auto & other : _workers) {
+          if (slot * s = _allocate(*other)) { return s; }
+        }
+        return nullptr;
+      }
+    }
+
+    template <typename T>
+    static void _fill(slot * s, T task)
+    {
+      T * t = new (s->data) T(std::move(task));
+      s->task = runnable::view(*t);
+      s->destroy = &_destroy<T>;
+      s->next = nullptr;
+    }
+
+    template <typename T>
+    static void _fill_chain(slot ** s, T last) { _fill(*s, std::move(last)); }
+
+    template <typename T, typename U, typename... Ts>
+    static void _fill_chain(slot ** s, T first, U second, Ts... rest)
+    {
+      _fill(*s, std::move(first));
+      _fill_chain(s + 1, std::move(second), std::move(rest)...);
+      s[0]->next = s[1];
+    }
+
+    // A free slot of w, nullptr if all are in use
+    slot * _allocate(worker & w)
+    {
+      std::lock_guard<std::mutex> lock(w.mutex);
+      return w.free_count ? w.free[--w.free_count] : nullptr;
+    }
+
+    void _release(slot * s)
+    {
+      worker & w = *_workers[s->owner];
+      std::lock_guard<std::mutex> lock(w.mutex);
+      w.free[w.free_count++] = s;
+    }
+
+    // Queues a placed task on the worker owning its slot
+    void _push(slot * s)
+    {
+      worker & w = *_workers[s->owner];
+      {
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.ready[(w.head + w.count) & w.mask] = s;
+        w.count++;
+      }
+      // pairs with the sleeper count and recheck in _worker_loop
+      _queued.fetch_add(1, std::memory_order_seq_cst);
+      if (_sleepers.load(std::memory_order_seq_cst) != 0) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _wake.notify_one();
+      }
+    }
+
+    slot * _pop(std::size_t index)
+    {
+      worker & w = *_workers[index];
+      std::lock_guard<std::mutex> lock(w.mutex);
+      if (w.count == 0) { return nullptr; }
+      w.count--;
+      return w.ready[(w.head + w.count) & w.mask];
+    }
+
+    slot * _steal(std::size_t index)
+    {
+      const std::size_t workers = _workers.size();
+      for (std::size_t k = 1; k < workers; k++) {
+        worker & w = *_workers[(index + k) % workers];
+        std::lock_guard<std::mutex> lock(w.mutex);
+        if (w.count != 0) {
+          slot * s = w.ready[w.head];
+          w.head = (w.head + 1) & w.mask;
+          w.count--;
+          return s;
+        }
+      }
+      return nullptr;
+    }
+
+    bool _run_one(std::size_t index)
+    {
+      slot * s = _pop(index);
+      if (!s) { s = _steal(index); }
+      if (!s) { return false; }
+      _queued.fetch_sub(1, std::memory_order_relaxed);
+
+      s->task.run();
+      slot * next = s->next;
+      s->destroy(s->data);
+      _release(s);
+      if (next) { _push(next); }
+      _pending.fetch_sub(1, std::memory_order_acq_rel);
+      return true;
+    }
+
+    void _worker_loop(std::size_t index)
+    {
+      _current_worker().scheduler = this;
+      _current_worker().index = index;
+      for (;;) {
+        if (_run_one(index)) { continue; }
+        // spin briefly before sleeping, tasks often come in bursts
+        bool found = false;
+        for (int i = 0; i < 64 && !found; i++) {
+          std::this_thread::yield();
+          found = _queued.load(std::memory_order_relaxed) != 0;
+        }
+        if (found) { continue; }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _sleepers.fetch_add(1, std::memory_order_seq_cst);
+        _wake.wait(lock, [this] {
+          return _stop || _queued.load(std::memory_order_seq_cst) != 0;
+        });
+        _sleepers.fetch_sub(1, std::memory_order_relaxed);
+        if (_stop) { return; }
+      }
+    }
+
+    std::vector<std::unique_ptr<worker>> _workers;
+    std::vector<std::thread> _threads;
+    std::atomic<std::size_t> _round_robin;
+    std::atomic<std::size_t> _queued;
+    std::atomic<std::size_t> _pending;
+    std::atomic<std::size_t> _sleepers;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    bool _stop;
+  };
+
+} // namespace archetype
+
+#endif //__ARCHETYPE_SCHEDULER_H__
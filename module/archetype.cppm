@@ -0,0 +1,58 @@
+// The archetype library as a C++20 named module. Importers include
+// archetype/macros.h for the macro API:
+//
+//   #include "archetype/macros.h"
+//   import archetype;
+//
+// Configuration macros, such as ARCHETYPE_TASK_SIZE, take effect when the
+// module is built, not where it is imported.
+module;
+
+// Every standard and system header the library uses, in the global module
+// fragment, so their includes inside the export block are guarded out
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+export module archetype;
+
+export {
+#include "archetype/archetype.h"
+#include "archetype/allocator.h"
+#include "archetype/async.h"
+#include "archetype/atomic.h"
+#include "archetype/borrow.h"
+#include "archetype/chunked.h"
+#include "archetype/compact.h"
+#include "archetype/inline_cache.h"
+#include "archetype/ipc.h"
+#include "archetype/memo_cache.h"
+#include "archetype/methods.h"
+#include "archetype/multi_dispatch.h"
+#include "archetype/multicast.h"
+#include "archetype/parallel.h"
+#include "archetype/pipeline.h"
+#include "archetype/recorder.h"
+#include "archetype/relocatable.h"
+#include "archetype/scheduler.h"
+}
@@ -0,0 +1,64 @@
+#!/bin/sh
+# Usage: module/rebuild_time.sh [doctest include dir]
+#
+# Times a full rebuild of the src/ and test/ translation units that use
+# archetype, once including the headers and once importing the module,
+# built first, with the same flags. Each build is run RUNS times, default
+# 3, and the fastest is kept. Calls GCC directly with -fmodules-ts, as
+# CMake only scans modules with GCC 14 and later. CXX picks the compiler.
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+cxx=${CXX:-g++}
+runs=${RUNS:-3}
+doctest=${1:-/usr/include}
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+flags="-std=gnu++20 -O0 -w -I$root/include -I$doctest"
+sources="src/basic_usage.cpp src/mixin_patterns.cpp src/multiinheritance.cpp
+         test/macro_test.cpp test/full_test.cpp"
+
+now() { date +%s.%N; }
+
+# seconds taken by a command, or "failed"
+timed() {
+  start=$(now)
+  if "$@" >/dev/null 2>&1; then
+    echo "$(now) $start" | awk '{ printf "%.2f", $1 - $2 }'
+  else
+    echo failed
+  fi
+}
+
+# fastest of runs timings of a command
+fastest() {
+  best=
+  i=0
+  while [ $i -lt "$runs" ]; do
+    t=$(timed "$@")
+    if [ "$t" = failed ]; then echo failed; return; fi
+    best=$(echo "$t $best" | awk '{ print ($2 == "" || $1 < $2) ? $1 : $2 }')
+    i=$((i + 1))
+  done
+  echo "$best"
+}
+
+# sum of two timings, failed if either is
+add() {
+  echo "$1 $2" | awk '{ print ($1 == "failed" || $2 == "failed") ? "failed" : $1 + $2 }'
+}
+
+cd "$out" || exit 1
+printf '%-28s %10s %10s\n' "" headers module
+module=$(fastest $cxx $flags -fmodules-ts -x c++ -c "$root/module/archetype.cppm" -o archetype.o)
+printf '%-28s %10s %10s\n' "module/archetype.cppm" - "$module"
+header_total=0
+module_total=$module
+for s in $sources; do
+  o=$(basename "$s" .cpp)
+  h=$(fastest $cxx $flags -c "$root/$s" -o "$o.o")
+  m=$(fastest $cxx $flags -fmodules-ts -DARCHETYPE_MODULE -c "$root/$s" -o "$o.m.o")
+  printf '%-28s %10s %10s\n' "$s" "$h" "$m"
+  header_total=$(add "$header_total" "$h")
+  module_total=$(add "$module_total" "$m")
+done
+printf '%-28s %10s %10s\n' "total" "$header_total" "$module_total"
@@ -23,6 +23,7 @@ stdenv.mkDerivation {
     "^include.*"
     "^src.*"
     "^test.*"
+    "^bench.*"
     "CMakeLists.txt"
   ];
 
@@ -1,8 +1,14 @@
-#include "archetype/archetype.h"
 #include <iostream>
 #include <cstring>
 #include <string>
 
+#ifdef ARCHETYPE_MODULE
+#include "archetype/macros.h"
+import archetype;
+#else
+#include "archetype/archetype.h"
+#endif
+
 
 // Define our archetypes
 ARCHETYPE_DEFINE(writable, (
@@ -1,8 +1,14 @@
-#include "archetype/archetype.h"
 #include <iostream>
 #include <cstring>
 #include <string>
 
+#ifdef ARCHETYPE_MODULE
+#include "archetype/macros.h"
+import archetype;
+#else
+#include "archetype/archetype.h"
+#endif
+
 // Here is a collection of readers and writers created in different ways
 class Writer {
 public:
@@ -85,6 +91,23 @@ struct DerivedReadWriter : public AbstractWriter, public AbstractReader
 };
 
 
+// Types without the required member functions can be adapted with free
+// functions found through argument dependent lookup. Unlike
+// ComposedReadWriter no forwarding object is needed, the vtable stubs call
+// these directly.
+struct ReaderWriterPair {
+  Reader reader;
+  Writer writer;
+};
+
+int read(ReaderWriterPair &rw, char *buf, size_t size) {
+  return rw.reader.read(buf, size);
+}
+
+int write(ReaderWriterPair &rw, const char *buf, size_t size) {
+  return rw.writer.write(buf, size);
+}
+
 
 // Define interfaces 
 ARCHETYPE_DEFINE(writable, (
@@ -189,6 +212,11 @@ int main()
   stateful_augmented_view.write_api("Hello from stateful augmentation\r\n");
 
 
+  // Augment a free function adapter
+  ReaderWriterPair reader_writer_pair;
+  WriteAPI<writable::view> adapted_write_view(reader_writer_pair);
+  adapted_write_view.write_api("Hello from a free function adapter\r\n");
+
   // Augment pointers with mixins
   readwritable::ptr<ReadWriteAPI> read_write_ptr(composed_read_writer_instance);
   char buf[5];
@@ -1,6 +1,12 @@
-#include "archetype/archetype.h"
 #include <iostream>
 
+#ifdef ARCHETYPE_MODULE
+#include "archetype/macros.h"
+import archetype;
+#else
+#include "archetype/archetype.h"
+#endif
+
 // Compose basic types that get composed through multi inheritance
 struct A {
   void do_a(void) {}
@@ -1,7 +1,46 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 
-#include "archetype/archetype.h"
 #include <doctest/doctest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <list>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef ARCHETYPE_MODULE
+#include "archetype/macros.h"
+import archetype;
+#else
+#include "archetype/archetype.h"
+#include "archetype/allocator.h"
+#include "archetype/atomic.h"
+#include "archetype/borrow.h"
+#include "archetype/chunked.h"
+#include "archetype/compact.h"
+#include "archetype/inline_cache.h"
+#include "archetype/memo_cache.h"
+#include "archetype/async.h"
+#include "archetype/ipc.h"
+#include "archetype/methods.h"
+#include "archetype/multi_dispatch.h"
+#include "archetype/multicast.h"
+#include "archetype/parallel.h"
+#include "archetype/pipeline.h"
+#include "archetype/recorder.h"
+#include "archetype/relocatable.h"
+#include "archetype/scheduler.h"
+#endif
 
 // Test fixtures for basic checks
 struct noarg_func {
@@ -183,4 +222,1655 @@ TEST_CASE("ARCHETYPE_COMPOSE") {
     CHECK(satisfies_ab::check<ACD>::value == false);
     CHECK(satisfies_ab::check<BCD>::value == false);
   }
-}
\ No newline at end of file
+}
+// Test fixtures for null views
+struct ref_func {
+  int value = 7;
+  int & func0() { return value; }
+};
+
+ARCHETYPE_DEFINE(basic_ref, (ARCHETYPE_METHOD(int &, func0)))
+
+TEST_CASE("null views") {
+  arg_func af;
+  multifunc m;
+  AB ab;
+
+  SUBCASE("default constructed views are null") {
+    basic_int::view biv;
+    CHECK(!biv);
+    CHECK(biv.func0(5) == 0);
+
+    basic_multifunc::view bmfv;
+    CHECK(!bmfv);
+    CHECK(bmfv.func0(5) == 0);
+    CHECK(bmfv.func1(5.4) == 0.0);
+
+    basic_void::view bvv;
+    bvv.func0();
+  }
+
+  SUBCASE("reference results") {
+    basic_ref::view brv;
+    CHECK(brv.func0() == 0);
+
+    // writes through a null result don't reach other null views
+    brv.func0() = 5;
+    basic_ref::view other;
+    CHECK(other.func0() == 0);
+    CHECK(brv.func0() == 0);
+
+    ref_func rf;
+    brv = basic_ref::view(rf);
+    brv.func0() = 3;
+    CHECK(rf.value == 3);
+  }
+
+  SUBCASE("binding and copying") {
+    basic_int::view biv;
+    biv = basic_int::view(af);
+    CHECK(static_cast<bool>(biv));
+    CHECK(biv.func0(5) == 10);
+
+    basic_int::view copied(biv);
+    CHECK(static_cast<bool>(copied));
+    CHECK(copied.func0(1) == 6);
+
+    basic_int::view null_view;
+    basic_int::view null_copy(null_view);
+    CHECK(!null_copy);
+
+    basic_multifunc::view bmfv(m);
+    CHECK(static_cast<bool>(bmfv));
+  }
+
+  SUBCASE("composed views") {
+    satisfies_ab::view sabv;
+    CHECK(!sabv);
+    sabv.do_a();
+    CHECK(sabv.do_b(5) == 0);
+
+    sabv = satisfies_ab::view(ab);
+    CHECK(static_cast<bool>(sabv));
+    CHECK(sabv.do_b(5) == 10);
+  }
+
+  SUBCASE("null pointer views") {
+    satisfies_ab::ptr<> sabp;
+    CHECK(!*sabp);
+    CHECK(sabp->do_b(5) == 0);
+  }
+}
+
+// Test fixtures for free function adapters
+namespace adapted {
+struct free_int {
+  int value = 5;
+};
+
+int func0(free_int &f, int a) { return f.value + a; }
+
+struct member_and_free {
+  int func0(int a) { return a + 100; }
+};
+
+int func0(member_and_free &, int a) { return a + 200; }
+
+struct free_ab {
+  int b = 1;
+};
+
+void do_a(free_ab &) {}
+int do_b(free_ab &f, int b) { return f.b + b; }
+} // namespace adapted
+
+TEST_CASE("free function adapters") {
+  adapted::free_int fi;
+  adapted::member_and_free mf;
+  adapted::free_ab fab;
+
+  SUBCASE("checking") {
+    CHECK(basic_int::check<adapted::free_int>::value == true);
+    CHECK(basic_void::check<adapted::free_int>::value == false);
+    CHECK(basic_multifunc::check<adapted::free_int>::value == false);
+    CHECK(satisfies_ab::check<adapted::free_ab>::value == true);
+    CHECK(satisfies_ac::check<adapted::free_ab>::value == false);
+  }
+
+  SUBCASE("calling") {
+    basic_int::view biv(fi);
+    CHECK(biv.func0(3) == 8);
+    fi.value = 10;
+    CHECK(biv.func0(3) == 13);
+
+    satisfies_ab::view sabv(fab);
+    sabv.do_a();
+    CHECK(sabv.do_b(4) == 5);
+  }
+
+  SUBCASE("member functions are preferred") {
+    basic_int::view biv(mf);
+    CHECK(biv.func0(1) == 101);
+  }
+}
+
+// Mixin for checking views with the same API
+template <typename V> struct twice_api : public V {
+  using V::V;
+  int func0_twice(int a) { return this->func0(this->func0(a)); }
+};
+
+TEST_CASE("static views") {
+  arg_func af;
+  multifunc m;
+  ABC abc;
+  adapted::free_int fi;
+
+  SUBCASE("calling") {
+    archetype::static_view<basic_int, arg_func> biv(af);
+    CHECK(static_cast<bool>(biv));
+    CHECK(biv.func0(5) == 10);
+
+    archetype::static_view<basic_multifunc, multifunc> bmfv(m);
+    CHECK(bmfv.func0(5) == 10);
+    CHECK(bmfv.func1(1.0) == doctest::Approx(6.3));
+  }
+
+  SUBCASE("composed") {
+    archetype::static_view<satisfies_abc, ABC> sabcv(abc);
+    sabcv.do_a();
+    CHECK(sabcv.do_b(5) == 10);
+    CHECK(sabcv.do_c('a') == 'd');
+    CHECK(satisfies_abc::check<archetype::static_view<satisfies_abc, ABC>>::value);
+  }
+
+  SUBCASE("free function adapters") {
+    archetype::static_view<basic_int, adapted::free_int> biv(fi);
+    CHECK(biv.func0(3) == 8);
+  }
+
+  SUBCASE("mixins") {
+    twice_api<basic_int::view> erased(af);
+    twice_api<archetype::static_view<basic_int, arg_func>> direct(af);
+    CHECK(erased.func0_twice(1) == 11);
+    CHECK(direct.func0_twice(1) == 11);
+  }
+
+  SUBCASE("size") {
+    CHECK(sizeof(archetype::static_view<basic_int, arg_func>) == sizeof(void *));
+  }
+}
+
+TEST_CASE("variant views") {
+  AB ab;
+  ABC abc;
+  ABD abd;
+  adapted::free_ab fab;
+
+  using ab_variant = archetype::variant_view<satisfies_ab, AB, ABC, ABD,
+                                             adapted::free_ab>;
+
+  SUBCASE("calling") {
+    ab_variant views[] = {ab, abc, abd, fab};
+    CHECK(views[0].index() == 0);
+    CHECK(views[1].index() == 1);
+    CHECK(views[2].index() == 2);
+    CHECK(views[3].index() == 3);
+
+    for (auto &view : views) {
+      view.do_a();
+    }
+    CHECK(views[0].do_b(5) == 10);
+    CHECK(views[2].do_b(1) == 6);
+    CHECK(views[3].do_b(1) == 2);
+  }
+
+  SUBCASE("copying") {
+    ab_variant view(abd);
+    ab_variant copy = view;
+    CHECK(copy.index() == 2);
+    CHECK(copy.do_b(1) == 6);
+    ab_variant assigned(ab);
+    assigned = view;
+    CHECK(assigned.index() == 2);
+  }
+
+  SUBCASE("mixins") {
+    arg_func af;
+    twice_api<archetype::variant_view<basic_int, arg_func, adapted::free_int>>
+        view(af);
+    CHECK(view.func0_twice(1) == 11);
+  }
+
+  SUBCASE("satisfies the archetype") {
+    CHECK(satisfies_ab::check<ab_variant>::value);
+    ab_variant variant(abc);
+    satisfies_ab::view erased_variant(variant);
+    CHECK(erased_variant.do_b(2) == 7);
+  }
+}
+
+TEST_CASE("compact views") {
+  AB ab;
+  ABC abc;
+  ABD abd;
+
+  SUBCASE("calling") {
+    archetype::compact_view<satisfies_ab> view(abc);
+    CHECK(static_cast<bool>(view));
+    view.do_a();
+    CHECK(view.do_b(5) == 10);
+
+    satisfies_ab::view erased(abd);
+    archetype::compact_view<satisfies_ab> from_erased(erased);
+    CHECK(from_erased.do_b(1) == 6);
+    CHECK(from_erased.to_view().do_b(1) == 6);
+  }
+
+  SUBCASE("null") {
+    archetype::compact_view<satisfies_ab> view;
+    CHECK(!view);
+    view.do_a();
+    CHECK(view.do_b(5) == 0);
+    CHECK(!view.to_view());
+  }
+
+  SUBCASE("size") {
+#if ARCHETYPE_COMPACT_PACKED
+    CHECK(sizeof(archetype::compact_view<satisfies_ab>) == sizeof(void *));
+#endif
+    CHECK(sizeof(archetype::compact_view<satisfies_ab>) <
+          sizeof(satisfies_ab::view));
+  }
+
+  SUBCASE("mixins") {
+    arg_func af;
+    twice_api<archetype::compact_view<basic_int>> view(af);
+    CHECK(view.func0_twice(1) == 11);
+    CHECK(satisfies_ab::check<archetype::compact_view<satisfies_ab>>::value);
+  }
+
+  SUBCASE("view arrays") {
+    archetype::view_array<satisfies_ab> views;
+    CHECK(views.empty());
+    views.push_back(ab);
+    views.push_back(abc);
+    views.push_back(satisfies_ab::view(abd));
+    CHECK(views.size() == 3);
+    CHECK(views[0].do_b(1) == 6);
+    CHECK(views[1].do_b(1) == 6);
+    CHECK(views[2].do_b(1) == 6);
+
+    int sum = 0;
+    views.for_each([&](archetype::compact_view<satisfies_ab> view) {
+      sum += view.do_b(1);
+    });
+    CHECK(sum == 18);
+
+    sum = 0;
+    for (auto view : views) {
+      sum += view.do_b(2);
+    }
+    CHECK(sum == 21);
+  }
+}
+
+TEST_CASE("parallel for_each") {
+  archetype::work_stealing_pool pool(4);
+  CHECK(pool.size() == 4);
+
+  std::vector<AB> abs(300);
+  std::vector<ABC> abcs(300);
+  std::vector<adapted::free_ab> fabs(300);
+
+  SUBCASE("pool runs every task once") {
+    std::vector<std::atomic<int>> hits(1000);
+    for (auto &h : hits) { h = 0; }
+    for (int round = 0; round < 3; round++) {
+      pool.run(hits.size(), [&](std::size_t i) { hits[i]++; });
+    }
+    bool all_three = true;
+    for (auto &h : hits) { all_three = all_three && h == 3; }
+    CHECK(all_three);
+  }
+
+  SUBCASE("view arrays") {
+    archetype::view_array<satisfies_ab> views;
+    for (std::size_t i = 0; i < 300; i++) {
+      views.push_back(abs[i]);
+      views.push_back(abcs[i]);
+      views.push_back(fabs[i]);
+    }
+    std::atomic<int> sum(0);
+    archetype::parallel_for_each(
+        pool, views,
+        [&](archetype::compact_view<satisfies_ab> v) { sum += v.do_b(1); }, 16);
+    CHECK(sum == 300 * (6 + 6 + 2));
+  }
+
+  SUBCASE("vectors of views") {
+    std::vector<satisfies_ab::view> views;
+    for (std::size_t i = 0; i < 300; i++) {
+      views.emplace_back(fabs[i]);
+      views.emplace_back(abs[i]);
+    }
+    std::atomic<int> sum(0);
+    archetype::parallel_for_each(
+        pool, views.begin(), views.end(),
+        [&](satisfies_ab::view &v) { sum += v.do_b(0); }, 7);
+    CHECK(sum == 300 * (1 + 5));
+  }
+
+  SUBCASE("vtable indices past the compact view limit") {
+    std::size_t types[] = {ARCHETYPE_MAX_COMPACT_VTABLES + 10, 3,
+                           ARCHETYPE_MAX_COMPACT_VTABLES + 10, 3};
+    archetype::type_chunks chunks(4, [&](std::size_t i) { return types[i]; }, 8);
+    CHECK(chunks.size() == 2);
+    std::vector<std::size_t> order;
+    auto collect = [&](std::size_t i) { order.push_back(i); };
+    for (std::size_t c = 0; c < chunks.size(); c++) { chunks.for_each_in(c, collect); }
+    CHECK(order == std::vector<std::size_t>{1, 3, 0, 2});
+  }
+}
+
+struct counting_b {
+  int total = 0;
+  int do_b(int b) { return total += b; }
+};
+
+ARCHETYPE_DEFINE(text_sink, (ARCHETYPE_METHOD(std::size_t, take, const std::string &)))
+
+struct text_length {
+  std::size_t take(const std::string &s) { return s.size(); }
+};
+
+TEST_CASE("async views") {
+  archetype::executor exec(8);
+  ABC abc;
+
+  SUBCASE("calls run on the executor") {
+    archetype::async_view<satisfies_abc> view(abc, exec);
+    CHECK(static_cast<bool>(view));
+    std::future<int> b = view.do_b(5);
+    std::future<char> c = view.do_c('a');
+    std::future<void> a = view.do_a();
+    CHECK(b.wait_for(std::chrono::seconds(0)) != std::future_status::ready);
+    CHECK(exec.run_pending() == 3);
+    CHECK(b.get() == 10);
+    CHECK(c.get() == 'd');
+    a.get();
+    CHECK(!exec.run_one());
+  }
+
+  SUBCASE("from other threads") {
+    arg_func af;
+    archetype::async_view<basic_int> view(basic_int::view(af), exec);
+    std::vector<std::future<int>> results;
+    std::thread producer([&] {
+      for (int i = 0; i < 100; i++) { results.push_back(view.func0(i)); }
+    });
+    std::size_t run = 0;
+    while (run < 100) { run += exec.run_pending(); }
+    producer.join();
+    int sum = 0;
+    for (auto &r : results) { sum += r.get(); }
+    CHECK(sum == 4950 + 500);
+  }
+
+  SUBCASE("fire and forget") {
+    counting_b counter;
+    archetype::async_view<satisfies_b, archetype::fire_and_forget> view(
+        counter, exec);
+    view.do_b(2);
+    view.do_b(3);
+    CHECK(counter.total == 0);
+    CHECK(exec.run_pending() == 2);
+    CHECK(counter.total == 5);
+  }
+
+  SUBCASE("arguments are copied") {
+    text_length sink;
+    archetype::async_view<text_sink> view(sink, exec);
+    std::future<std::size_t> n;
+    {
+      std::string text = "copied";
+      n = view.take(text);
+    }
+    CHECK(exec.run_pending() == 1);
+    CHECK(n.get() == 6);
+
+    CHECK(archetype::async_signature<int(int, const std::string &)>::value);
+    CHECK(!archetype::async_signature<void(int &)>::value);
+    CHECK(!archetype::async_signature<void(const char *)>::value);
+  }
+
+  SUBCASE("pending calls are dropped with the executor") {
+    std::future<int> b;
+    {
+      archetype::executor local;
+      archetype::async_view<satisfies_abc> view(abc, local);
+      b = view.do_b(1);
+    }
+    CHECK_THROWS_AS(b.get(), std::future_error);
+  }
+}
+
+struct tracking_abc {
+  std::string log;
+  void do_a() { log += "a "; }
+  int do_b(int b) {
+    log += "b" + std::to_string(b) + " ";
+    return b;
+  }
+  char do_c(char c) {
+    log += std::string("c") + c + " ";
+    return c;
+  }
+};
+
+TEST_CASE("recording calls") {
+  SUBCASE("replay") {
+    archetype::call_buffer buffer;
+    archetype::recorder<satisfies_abc> rec(buffer);
+    CHECK(rec.do_b(5) == 0);
+    rec.do_a();
+    rec.do_c('x');
+    rec.do_b(7);
+    CHECK(buffer.size() == 4 * sizeof(unsigned short) + 2 * sizeof(int) + 1);
+
+    tracking_abc target;
+    CHECK(archetype::replay(buffer, satisfies_abc::view(target)));
+    CHECK(target.log == "b5 a cx b7 ");
+  }
+
+  SUBCASE("another archetype") {
+    archetype::call_buffer buffer;
+    archetype::recorder<satisfies_ab> rec(buffer);
+    rec.do_b(1);
+
+    // the ids belong to satisfies_ab, so they aren't replayed on satisfies_abc
+    tracking_abc target;
+    CHECK(!archetype::replay(buffer, satisfies_abc::view(target)));
+    CHECK(target.log.empty());
+    CHECK(archetype::replay(buffer, satisfies_ab::view(target)));
+    CHECK(target.log == "b1 ");
+
+    buffer.clear();
+    CHECK(buffer.archetype() == nullptr);
+    archetype::recorder<satisfies_abc> other(buffer);
+    other.do_c('y');
+    CHECK(archetype::replay(buffer, satisfies_abc::view(target)));
+    CHECK(target.log == "b1 cy ");
+  }
+
+  SUBCASE("through a view") {
+    archetype::call_buffer buffer;
+    archetype::recorder<satisfies_ab> rec(buffer);
+    satisfies_ab::view view(rec);
+    view.do_b(1);
+    view.do_b(2);
+
+    tracking_abc first, second;
+    satisfies_ab::view v1(first), v2(second);
+    archetype::replay(buffer, v1);
+    archetype::replay(buffer, v2);
+    CHECK(first.log == "b1 b2 ");
+    CHECK(second.log == "b1 b2 ");
+  }
+
+  SUBCASE("recordable parameters") {
+    CHECK(archetype::recorded_signature<void(int, const double &)>::value);
+    CHECK(!archetype::recorded_signature<void(const char *)>::value);
+    CHECK(!archetype::recorded_signature<void(int &)>::value);
+  }
+
+  SUBCASE("empty buffer") {
+    archetype::call_buffer buffer;
+    tracking_abc target;
+    archetype::replay(buffer, satisfies_abc::view(target));
+    CHECK(target.log.empty());
+  }
+}
+
+ARCHETYPE_DEFINE(string_appender, (ARCHETYPE_METHOD(void, append, std::string &)))
+
+struct appends_char {
+  char c;
+  void append(std::string &s) { s += c; }
+};
+
+TEST_CASE("multicast") {
+  SUBCASE("calls every subscriber") {
+    counting_b first, second;
+    adapted::free_ab third;
+    archetype::multicast<satisfies_b> events;
+    CHECK(events.do_b(1) == 0);
+    events.subscribe(first);
+    events.subscribe(second);
+    events.subscribe(third);
+    CHECK(events.size() == 3);
+    events.do_b(2);
+    CHECK(first.total == 2);
+    CHECK(second.total == 2);
+
+    events.unsubscribe(first);
+    CHECK(events.size() == 2);
+    events.do_b(3);
+    CHECK(first.total == 2);
+    CHECK(second.total == 5);
+  }
+
+  SUBCASE("combining results") {
+    counting_b first, second;
+    adapted::free_ab third;
+    archetype::multicast<satisfies_b, archetype::sum_results> sum;
+    sum.subscribe(first);
+    sum.subscribe(second);
+    sum.subscribe(third);
+    CHECK(sum.do_b(1) == 1 + 1 + 2);
+
+    archetype::multicast<satisfies_b> last;
+    last.subscribe(first);
+    CHECK(last.do_b(4) == 5);
+  }
+
+  SUBCASE("reference arguments reach every subscriber") {
+    appends_char a{'a'}, b{'b'};
+    archetype::multicast<string_appender> events;
+    events.subscribe(a);
+    events.subscribe(b);
+    std::string s;
+    events.append(s);
+    CHECK(s.size() == 2);
+    CHECK(s.find('a') != std::string::npos);
+    CHECK(s.find('b') != std::string::npos);
+  }
+
+  SUBCASE("satisfies the archetype") {
+    counting_b first;
+    archetype::multicast<satisfies_b> events;
+    events.subscribe(first);
+    satisfies_b::view view(events);
+    view.do_b(7);
+    CHECK(first.total == 7);
+  }
+
+  SUBCASE("publishing while subscribing") {
+    adapted::free_ab first, second;
+    archetype::multicast<satisfies_b, archetype::sum_results> events;
+    events.subscribe(first);
+    std::atomic<bool> done(false);
+    std::thread publisher([&] {
+      while (!done) { CHECK(events.do_b(0) >= 1); }
+    });
+    for (int i = 0; i < 100; i++) {
+      events.subscribe(second);
+      events.unsubscribe(second);
+    }
+    done = true;
+    publisher.join();
+    CHECK(events.size() == 1);
+  }
+}
+
+TEST_CASE("method metadata") {
+  using abc_methods = archetype::method_table<satisfies_abc>;
+
+  SUBCASE("constant expressions") {
+    static_assert(abc_methods::size == 3, "satisfies_abc has 3 methods");
+    static_assert(abc_methods::find("do_c") == 2, "components come first");
+    static_assert(abc_methods::find("do_x") == abc_methods::size,
+                  "unknown names are not found");
+    CHECK(std::string(abc_methods::name(1)) == "do_b");
+    CHECK(std::string(abc_methods::signature(0)) == "void()");
+    CHECK(std::string(abc_methods::signature(2)) == "char(char)");
+  }
+
+  SUBCASE("dispatch by name") {
+    tracking_abc target;
+    satisfies_abc::view view(target);
+
+    int b = 4;
+    void *b_args[] = {&b};
+    int b_result = 0;
+    CHECK(abc_methods::invoke(view, "do_b", b_args, &b_result));
+    CHECK(b_result == 4);
+
+    char c = 'q';
+    void *c_args[] = {&c};
+    char c_result = 0;
+    CHECK(abc_methods::invoke(view, "do_c", c_args, &c_result));
+    CHECK(c_result == 'q');
+
+    CHECK(abc_methods::invoke(view, "do_a", nullptr, nullptr));
+    CHECK(target.log == "b4 cq a ");
+
+    CHECK(!abc_methods::invoke(view, "do_x", nullptr, nullptr));
+    CHECK(abc_methods::lookup("do_") == nullptr);
+    CHECK(std::string(abc_methods::lookup("do_c")->signature) == "char(char)");
+  }
+
+  SUBCASE("reference results") {
+    ref_func rf;
+    basic_ref::view view(rf);
+    int *result = nullptr;
+    CHECK(archetype::method_table<basic_ref>::invoke(view, "func0", nullptr, &result));
+    CHECK(result == &rf.value);
+    CHECK(std::string(archetype::method_table<basic_ref>::signature(0)) == "int &()");
+  }
+}
+
+ARCHETYPE_DEFINE(remote_store,
+                 (ARCHETYPE_METHOD(int, put, const char *, int),
+                  ARCHETYPE_METHOD(std::size_t, checksum, archetype::ipc_span),
+                  ARCHETYPE_METHOD(void, clear)))
+
+struct local_store {
+  std::string keys;
+  int total = 0;
+  const void *last_data = nullptr;
+
+  int put(const char *key, int value) {
+    keys += key;
+    return total += value;
+  }
+
+  std::size_t checksum(archetype::ipc_span bytes) {
+    last_data = bytes.data;
+    std::size_t sum = 0;
+    for (std::size_t i = 0; i < bytes.size; i++) {
+      sum += static_cast<const unsigned char *>(bytes.data)[i];
+    }
+    return sum;
+  }
+
+  void clear() {
+    keys.clear();
+    total = 0;
+  }
+};
+
+// Appends the bytes of value to a hand built request
+template <typename T>
+void put_bytes(std::vector<unsigned char> &request, const T &value) {
+  const unsigned char *p = reinterpret_cast<const unsigned char *>(&value);
+  request.insert(request.end(), p, p + sizeof(T));
+}
+
+// Sends a hand built request, optionally with a forged length in its
+// message header, and returns the size of the response
+std::size_t send_raw(archetype::ipc_channel &channel,
+                     const std::vector<unsigned char> &request,
+                     std::uint32_t forged_length = 0) {
+  unsigned char *raw = channel.requests().begin_write(request.size());
+  if (!raw) { return ~std::size_t(0); }
+  std::memcpy(raw, request.data(), request.size());
+  if (forged_length) { std::memcpy(raw - 8, &forged_length, sizeof(forged_length)); }
+  channel.requests().commit_write();
+  std::size_t n = ~std::size_t(0);
+  channel.responses().read(n);
+  channel.responses().end_read();
+  return n;
+}
+
+TEST_CASE("ipc proxies") {
+  std::string name = "/archetype-test-" + std::to_string(::getpid());
+  archetype::ipc_channel server_side, client_side;
+  REQUIRE(server_side.create(name.c_str(), 512, 4096));
+  REQUIRE(client_side.open(name.c_str()));
+  CHECK(!archetype::ipc_channel().open("/archetype-test-missing"));
+
+  local_store store;
+  archetype::ipc_server<remote_store> server(server_side, remote_store::view(store));
+  std::atomic<bool> done(false);
+  std::thread serving([&] {
+    while (!done) {
+      if (!server.poll()) { std::this_thread::yield(); }
+    }
+  });
+
+  archetype::ipc_client<remote_store> client(client_side);
+  CHECK(static_cast<bool>(client));
+  CHECK(remote_store::check<archetype::ipc_client<remote_store>>::value);
+
+  // strings are copied through the ring, repeated calls wrap it
+  int last = 0;
+  for (int i = 1; i <= 50; i++) { last = client.put("k", i); }
+  CHECK(last == 1275);
+
+  // inline buffers are copied, scratch buffers are sent by offset
+  unsigned char local[100];
+  for (int i = 0; i < 100; i++) { local[i] = 1; }
+  CHECK(client.checksum(archetype::ipc_span{local, sizeof(local)}) == 100);
+
+  unsigned char *shared =
+      static_cast<unsigned char *>(client_side.scratch(1000));
+  REQUIRE(shared != nullptr);
+  for (int i = 0; i < 1000; i++) { shared[i] = 2; }
+  CHECK(client.checksum(archetype::ipc_span{shared, 1000}) == 2000);
+  CHECK(server_side.in_scratch(store.last_data, 1000));
+
+  // requests larger than half the ring fail instead of waiting for room
+  CHECK(client.failed() == 0);
+  std::string long_key(300, 'x');
+  CHECK(client.put(long_key.c_str(), 5) == 0);
+  CHECK(client.failed() == 1);
+
+  // malformed requests get an empty response and make no call
+  const std::string keys = store.keys;
+  const std::uint32_t put_id = 0, checksum_id = 1;
+  std::vector<unsigned char> request;
+
+  put_bytes(request, std::uint32_t(7));
+  CHECK(send_raw(client_side, request) == 0);
+
+  // a string longer than the request, without a terminator, or with the
+  // int after it missing
+  request.clear();
+  put_bytes(request, put_id);
+  put_bytes(request, std::uint32_t(1000));
+  put_bytes(request, 'k');
+  put_bytes(request, char(0));
+  CHECK(send_raw(client_side, request) == 0);
+
+  request.clear();
+  put_bytes(request, put_id);
+  put_bytes(request, std::uint32_t(2));
+  put_bytes(request, 'a');
+  put_bytes(request, 'b');
+  put_bytes(request, 1);
+  CHECK(send_raw(client_side, request) == 0);
+
+  request.clear();
+  put_bytes(request, put_id);
+  put_bytes(request, std::uint32_t(2));
+  put_bytes(request, 'a');
+  put_bytes(request, char(0));
+  CHECK(send_raw(client_side, request) == 0);
+
+  // a shared buffer past the end of the scratch area, and an inline
+  // buffer longer than the request
+  request.clear();
+  put_bytes(request, checksum_id);
+  put_bytes(request, char(1));
+  put_bytes(request, std::uint64_t(4000));
+  put_bytes(request, std::uint64_t(100));
+  CHECK(send_raw(client_side, request) == 0);
+
+  request.clear();
+  put_bytes(request, checksum_id);
+  put_bytes(request, char(1));
+  put_bytes(request, ~std::uint64_t(0));
+  put_bytes(request, std::uint64_t(2));
+  CHECK(send_raw(client_side, request) == 0);
+
+  request.clear();
+  put_bytes(request, checksum_id);
+  put_bytes(request, char(0));
+  put_bytes(request, std::uint64_t(0));
+  put_bytes(request, std::uint64_t(1000));
+  put_bytes(request, 0);
+  CHECK(send_raw(client_side, request) == 0);
+
+  // a message header claiming more than the ring holds
+  request.clear();
+  put_bytes(request, put_id);
+  put_bytes(request, std::uint32_t(2));
+  put_bytes(request, 'a');
+  put_bytes(request, char(0));
+  put_bytes(request, 1);
+  CHECK(send_raw(client_side, request, 400) == 0);
+
+  CHECK(store.keys == keys);
+  CHECK(client.put("a", 0) == store.total);
+
+  client.clear();
+  CHECK(client.put("z", 1) == 1);
+
+  done = true;
+  serving.join();
+  CHECK(store.keys == "z");
+}
+
+TEST_CASE("ipc channels reject headers that don't fit the region") {
+  std::string name = "/archetype-test-forged-" + std::to_string(::getpid());
+  int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  REQUIRE(fd >= 0);
+  const std::size_t bytes = 4096;
+  REQUIRE(::ftruncate(fd, bytes) == 0);
+  void *base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  REQUIRE(base != MAP_FAILED);
+  // magic, ring_bytes and scratch_bytes lead the header
+  std::uint64_t *header = static_cast<std::uint64_t *>(base);
+  header[0] = 0x61726368495043ull;
+
+  header[1] = 1 << 20;
+  header[2] = 0;
+  CHECK(!archetype::ipc_channel().open(name.c_str()));
+
+  header[1] = 1000;
+  CHECK(!archetype::ipc_channel().open(name.c_str()));
+
+  header[1] = 1024;
+  header[2] = ~std::uint64_t(0);
+  CHECK(!archetype::ipc_channel().open(name.c_str()));
+
+  header[2] = 64;
+  CHECK(archetype::ipc_channel().open(name.c_str()));
+
+  ::munmap(base, bytes);
+  ::shm_unlink(name.c_str());
+}
+
+ARCHETYPE_DEFINE(has_size, (ARCHETYPE_FIELD(int, size)))
+ARCHETYPE_DEFINE(has_label, (ARCHETYPE_FIELD(const char *, label),
+                             ARCHETYPE_METHOD(int, do_b, int)))
+ARCHETYPE_COMPOSE(has_size_label, has_size, has_label)
+
+struct sized_base {
+  double weight = 1.5;
+  int size = 3;
+};
+
+struct sized_b : public sized_base, public B {
+  const char *label = "sized";
+};
+
+struct wrong_size {
+  long size;
+};
+
+struct size_method {
+  int size() { return 0; }
+};
+
+TEST_CASE("fields") {
+  SUBCASE("check the member type") {
+    CHECK(has_size::check<sized_b>::value);
+    CHECK(has_size_label::check<sized_b>::value);
+    CHECK_FALSE(has_size::check<wrong_size>::value);
+    CHECK_FALSE(has_size::check<size_method>::value);
+    CHECK_FALSE(has_size_label::check<sized_base>::value);
+  }
+
+  SUBCASE("read and write through views") {
+    sized_b s;
+    has_size::view v(s);
+    CHECK(v.size() == 3);
+    v.size() = 7;
+    CHECK(s.size == 7);
+    CHECK(&v.size() == &s.size);
+
+    archetype::static_view<has_size, sized_b> sv(s);
+    CHECK(sv.size() == 7);
+  }
+
+  SUBCASE("in composed archetypes") {
+    sized_b s;
+    has_size_label::view v(s);
+    CHECK(v.size() == 3);
+    CHECK(std::string(v.label()) == "sized");
+    CHECK(v.do_b(1) == 6);
+  }
+
+  SUBCASE("null views read the null result") {
+    has_size::view v;
+    CHECK(v.size() == 0);
+
+    // writes through a null view don't reach other null views
+    v.size() = 4;
+    has_size::view other;
+    CHECK(other.size() == 0);
+  }
+}
+
+struct money {
+  int cents;
+};
+
+ARCHETYPE_DEFINE(int_order, (ARCHETYPE_OPERATOR(bool, (), int, int)))
+ARCHETYPE_DEFINE(money_key, (ARCHETYPE_OPERATOR(bool, <, const money &),
+                             ARCHETYPE_OPERATOR(bool, ==, const money &)))
+ARCHETYPE_DEFINE(int_table, (ARCHETYPE_OPERATOR(int &, [], std::size_t)))
+ARCHETYPE_DEFINE(text_hash, (ARCHETYPE_OPERATOR(std::size_t, (), const std::string &)))
+ARCHETYPE_DEFINE(text_equal, (ARCHETYPE_OPERATOR(bool, (), const std::string &,
+                                                 const std::string &)))
+
+struct descending {
+  bool operator()(int a, int b) const { return a > b; }
+};
+
+struct wallet {
+  int cents;
+  bool operator<(const money &m) { return cents < m.cents; }
+};
+
+// free operator, found through argument dependent lookup
+bool operator==(wallet &w, const money &m) { return w.cents == m.cents; }
+
+struct length_hash {
+  std::size_t operator()(const std::string &s) const { return s.size(); }
+};
+
+struct case_blind_equal {
+  bool operator()(const std::string &a, const std::string &b) const {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+             return (x | 0x20) == (y | 0x20);
+           });
+  }
+};
+
+TEST_CASE("operator methods") {
+  SUBCASE("check") {
+    CHECK(int_order::check<descending>::value);
+    CHECK(money_key::check<wallet>::value);
+    CHECK(int_table::check<std::vector<int>>::value);
+    CHECK_FALSE(int_order::check<wallet>::value);
+    CHECK(archetype::method_table<money_key>::find("operator==") == 1);
+  }
+
+  SUBCASE("member and free operators") {
+    wallet w{250};
+    money_key::view v(w);
+    CHECK(v < money{300});
+    CHECK_FALSE(v < money{200});
+    CHECK(v == money{250});
+    CHECK_FALSE(money_key::view() == money{250});
+  }
+
+  SUBCASE("subscript") {
+    std::vector<int> values{1, 2, 3};
+    int_table::view table(values);
+    table[1] = 5;
+    CHECK(values[1] == 5);
+  }
+
+  SUBCASE("comparators in algorithms") {
+    descending d;
+    int_order::view order(d);
+    std::vector<int> values{3, 1, 4, 1, 5};
+    std::sort(values.begin(), values.end(), order);
+    CHECK(values == std::vector<int>{5, 4, 3, 1, 1});
+  }
+
+  SUBCASE("hashers in containers") {
+    length_hash h;
+    case_blind_equal e;
+    std::unordered_map<std::string, int, text_hash::view, text_equal::view>
+        counts(8, text_hash::view(h), text_equal::view(e));
+    counts["Key"]++;
+    counts["key"]++;
+    counts["other"]++;
+    CHECK(counts.size() == 2);
+    CHECK(counts["KEY"] == 2);
+  }
+}
+
+struct split_lines {
+  bool process(const archetype::buffer_slice &in,
+               archetype::slice_sink::view &out) {
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < in.size(); i++) {
+      if (in.data()[i] == '\n') {
+        if (!out.push(in.slice(start, i - start))) { return false; }
+        start = i + 1;
+      }
+    }
+    return true;
+  }
+};
+
+struct upper_case {
+  bool process(const archetype::buffer_slice &in,
+               archetype::slice_sink::view &out) {
+    archetype::buffer_slice copy = archetype::buffer_slice::allocate(in.size());
+    char *p = copy.mutable_data();
+    for (std::size_t i = 0; i < in.size(); i++) { p[i] = in.data()[i] & ~0x20; }
+    return out.push(copy);
+  }
+};
+
+struct collect_slices {
+  std::vector<std::string> lines;
+  std::vector<const char *> starts;
+  std::size_t limit = 100;
+
+  bool push(const archetype::buffer_slice &s) {
+    lines.push_back(std::string(s.data(), s.size()));
+    starts.push_back(s.data());
+    return lines.size() < limit;
+  }
+};
+
+TEST_CASE("pipelines") {
+  const char text[] = "one\ntwo\nthree\n";
+
+  SUBCASE("slices share their block") {
+    archetype::buffer_slice a = archetype::buffer_slice::allocate(4);
+    CHECK(a.mutable_data() != nullptr);
+    archetype::buffer_slice b = a.slice(1, 2);
+    CHECK(b.data() == a.data() + 1);
+    CHECK(a.mutable_data() == nullptr);
+    b = archetype::buffer_slice();
+    CHECK(a.mutable_data() != nullptr);
+    CHECK(archetype::buffer_slice::borrow(text, 3).mutable_data() == nullptr);
+  }
+
+  SUBCASE("stages pass sub slices without copying") {
+    archetype::slice_chunks source(
+        archetype::buffer_slice::borrow(text, sizeof(text) - 1), 100);
+    split_lines split;
+    collect_slices sink;
+    archetype::pipeline p;
+    p.then(split);
+    CHECK(p.run(source, sink));
+    CHECK(sink.lines == std::vector<std::string>{"one", "two", "three"});
+    CHECK(sink.starts[1] == text + 4);
+  }
+
+  SUBCASE("threaded stages") {
+    archetype::slice_chunks source(
+        archetype::buffer_slice::borrow(text, sizeof(text) - 1), 100);
+    split_lines split;
+    upper_case upper;
+    collect_slices sink;
+    archetype::pipeline p(1);
+    p.then_threaded(split).then_threaded(upper);
+    CHECK(p.run(source, sink));
+    CHECK(sink.lines == std::vector<std::string>{"ONE", "TWO", "THREE"});
+  }
+
+  SUBCASE("the sink stops the stream") {
+    std::string many;
+    for (int i = 0; i < 1000; i++) { many += "line\n"; }
+    archetype::slice_chunks source(
+        archetype::buffer_slice::borrow(many.data(), many.size()), 64);
+    split_lines split;
+    collect_slices sink;
+    sink.limit = 10;
+    archetype::pipeline p(2);
+    p.then_threaded(split);
+    CHECK_FALSE(p.run(source, sink));
+    CHECK(sink.lines.size() == 10);
+  }
+}
+
+ARCHETYPE_DEFINE(byte_readable, (ARCHETYPE_METHOD(int, read, char *, size_t)))
+
+// Hands out at most 3 bytes per read, to exercise refilling
+struct trickle_reader {
+  std::string text;
+  std::size_t offset = 0;
+
+  int read(char *buf, size_t n) {
+    n = std::min(std::min(n, size_t(3)), text.size() - offset);
+    std::memcpy(buf, text.data() + offset, n);
+    offset += n;
+    return static_cast<int>(n);
+  }
+};
+
+// Lines parsed in place from any borrowing reader
+std::vector<std::string> borrowed_lines(archetype::borrowing_reader::view in) {
+  std::vector<std::string> lines;
+  for (;;) {
+    archetype::read_window w = in.peek(1);
+    if (w.size == 0) { break; }
+    const char *end;
+    // ask for more than is held until the line is complete
+    while (!(end = static_cast<const char *>(std::memchr(w.data, '\n', w.size)))) {
+      std::size_t held = w.size;
+      w = in.peek(held + 1);
+      if (w.size == held) {
+        end = w.data + w.size;
+        break;
+      }
+    }
+    lines.push_back(std::string(w.data, end));
+    in.consume(static_cast<std::size_t>(end - w.data) + 1);
+  }
+  return lines;
+}
+
+TEST_CASE("borrowing readers") {
+  const std::vector<std::string> expected{"alpha", "beta", "gamma"};
+
+  SUBCASE("mapped files are read in place") {
+    char path[] = "/tmp/archetype-borrow-XXXXXX";
+    int fd = ::mkstemp(path);
+    REQUIRE(fd >= 0);
+    const char text[] = "alpha\nbeta\ngamma\n";
+    CHECK(::write(fd, text, sizeof(text) - 1) == sizeof(text) - 1);
+    ::close(fd);
+
+    archetype::mapped_file file;
+    REQUIRE(file.open(path));
+    ::unlink(path);
+    CHECK(file.size() == sizeof(text) - 1);
+    const char *first = file.peek(1).data;
+    CHECK(borrowed_lines(file) == expected);
+    CHECK(file.peek(1).size == 0);
+    CHECK(file.peek(0).data == first + file.size());
+    CHECK_FALSE(archetype::mapped_file().open("/nonexistent/archetype"));
+  }
+
+  SUBCASE("any readable through a buffer") {
+    trickle_reader trickle;
+    trickle.text = "alpha\nbeta\ngamma";
+    archetype::reader_buffer<byte_readable::view> buffered(trickle, 4);
+    CHECK(borrowed_lines(buffered) == expected);
+    CHECK(buffered.peek(1).size == 0);
+  }
+
+  SUBCASE("peek waits for min bytes") {
+    trickle_reader trickle;
+    trickle.text = "0123456789";
+    archetype::reader_buffer<trickle_reader &> buffered(trickle, 2);
+    archetype::read_window w = buffered.peek(8);
+    CHECK(w.size >= 8);
+    CHECK(std::string(w.data, 8) == "01234567");
+    buffered.consume(8);
+    CHECK(buffered.peek(8).size == 2);
+  }
+}
+
+ARCHETYPE_DEFINE(self_checking, (ARCHETYPE_METHOD(int, verify)))
+
+// The magic number sits at a different offset in each type, so calling one
+// type's stub on the other type's object reads a zero
+struct magic_first {
+  unsigned magic = 0xA;
+  unsigned pad = 0;
+  int verify() { return magic == 0xA ? 1 : 0; }
+};
+
+struct magic_second {
+  unsigned pad = 0;
+  unsigned magic = 0xB;
+  int verify() { return magic == 0xB ? 2 : 0; }
+};
+
+ARCHETYPE_DEFINE(string_out, (ARCHETYPE_METHOD(void, fill, std::string &)))
+
+struct triples {
+  void fill(std::string &s) { s = s + s + s; }
+};
+
+TEST_CASE("atomic views") {
+  SUBCASE("load, store and exchange") {
+    magic_first a;
+    magic_second b;
+    archetype::atomic_view<self_checking> v;
+    CHECK_FALSE(v);
+    CHECK(v.verify() == 0);
+    v.store(a);
+    CHECK(v);
+    CHECK(v.verify() == 1);
+    self_checking::view old = v.exchange(self_checking::view(b));
+    CHECK(old.verify() == 1);
+    CHECK(v.verify() == 2);
+    CHECK(v.load().verify() == 2);
+    CHECK(self_checking::check<archetype::atomic_view<self_checking>>::value);
+  }
+
+  SUBCASE("calls never see a torn binding") {
+    magic_first a[4];
+    magic_second b[4];
+    archetype::atomic_view<self_checking> v(a[0]);
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+    std::atomic<int> calls(0);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; r++) {
+      readers.emplace_back([&] {
+        while (!done) {
+          if (v.verify() == 0) { torn++; }
+          calls++;
+        }
+      });
+    }
+    for (int i = 0; i < 20000 || calls < 20000; i++) {
+      if (i & 1) {
+        v.store(a[i & 3]);
+      } else {
+        v.store(b[i & 3]);
+      }
+      if ((i & 255) == 0) { std::this_thread::yield(); }
+    }
+    done = true;
+    for (auto &t : readers) { t.join(); }
+    CHECK(torn == 0);
+  }
+
+  SUBCASE("reference arguments reach the object") {
+    triples t;
+    archetype::atomic_view<string_out> v(t);
+    std::string s = "x";
+    v.fill(s);
+    CHECK(s == "xxx");
+  }
+}
+
+// Test fixtures for inline caches
+ARCHETYPE_DEFINE(int_out, (ARCHETYPE_METHOD(void, fill, int &)))
+
+struct fills_seven {
+  void fill(int &x) { x = 7; }
+};
+
+TEST_CASE("inline caches") {
+  SUBCASE("registered types hit, others miss") {
+    B b;
+    counting_b counting;
+    BC bc;
+    archetype::inline_cache<satisfies_b, B, counting_b> site;
+    CHECK(site.hit_rate() == 0.0);
+
+    CHECK(site(satisfies_b::view(b)).do_b(1) == 6);
+    CHECK(site(satisfies_b::view(counting)).do_b(3) == 3);
+    CHECK(site(satisfies_b::view(counting)).do_b(4) == 7);
+    CHECK(site(satisfies_b::view(bc)).do_b(2) == 7);
+    CHECK(site.hits() == 3);
+    CHECK(site.misses() == 1);
+    CHECK(site.hit_rate() == 0.75);
+
+    // a null view misses, and gets the null stub
+    CHECK(site(satisfies_b::view()).do_b(2) == 0);
+    CHECK(site.misses() == 2);
+
+    site.reset_stats();
+    CHECK(site.hits() == 0);
+    CHECK(site.misses() == 0);
+  }
+
+  SUBCASE("reference arguments reach the object") {
+    fills_seven f;
+    archetype::inline_cache<int_out, fills_seven> site;
+    int x = 0;
+    site(int_out::view(f)).fill(x);
+    CHECK(x == 7);
+    CHECK(site.hits() == 1);
+  }
+}
+
+// Test fixtures for multi dispatch
+int b_with_c(B &, C &, int x) { return x + 1; }
+int bc_with_c(BC &, C &, int x) { return x + 2; }
+int b_with_bc(B &, BC &, int x) { return x + 3; }
+int unhandled(const satisfies_b::view &, const satisfies_c::view &, int) { return -1; }
+
+int b_with_bd(B &, BD &, int x) { return x * 10; }
+
+TEST_CASE("multi dispatch") {
+  SUBCASE("handlers are picked by both types") {
+    B b;
+    BC bc;
+    C c;
+    CD cd;
+    archetype::multi_dispatch<satisfies_b, satisfies_c, int(int)> table;
+    table.add<B, C, &b_with_c>().add<BC, C, &bc_with_c>().add<B, BC, &b_with_bc>();
+
+    CHECK(table(satisfies_b::view(b), satisfies_c::view(c), 1) == 2);
+    CHECK(table(satisfies_b::view(bc), satisfies_c::view(c), 1) == 3);
+    CHECK(table(satisfies_b::view(b), satisfies_c::view(bc), 1) == 4);
+    CHECK(table.handles(satisfies_b::view(b), satisfies_c::view(c)));
+
+    // unregistered pairs and null views go to the fallback
+    CHECK_FALSE(table.handles(satisfies_b::view(bc), satisfies_c::view(cd)));
+    CHECK(table(satisfies_b::view(bc), satisfies_c::view(cd), 1) == 0);
+    CHECK(table(satisfies_b::view(), satisfies_c::view(c), 1) == 0);
+
+    archetype::multi_dispatch<satisfies_b, satisfies_c, int(int)> custom(&unhandled);
+    custom.add<B, C, &b_with_c>();
+    CHECK(custom(satisfies_b::view(b), satisfies_c::view(c), 1) == 2);
+    CHECK(custom(satisfies_b::view(bc), satisfies_c::view(c), 1) == -1);
+  }
+
+  SUBCASE("symmetric handlers swap their arguments") {
+    B b;
+    BD bd;
+    archetype::multi_dispatch<satisfies_b, satisfies_b, int(int)> table;
+    table.add_symmetric<B, BD, &b_with_bd>();
+    CHECK(table(satisfies_b::view(b), satisfies_b::view(bd), 2) == 20);
+    CHECK(table(satisfies_b::view(bd), satisfies_b::view(b), 3) == 30);
+    CHECK_FALSE(table.handles(satisfies_b::view(b), satisfies_b::view(b)));
+  }
+}
+
+// Test fixtures for chunked sources
+struct countdown {
+  int left;
+  bool next(int &x) {
+    if (left == 0) { return false; }
+    x = left--;
+    return true;
+  }
+};
+
+TEST_CASE("chunked sources") {
+  SUBCASE("containers are read a chunk at a time") {
+    std::vector<int> values = {1, 2, 3, 4, 5, 6, 7};
+    auto chunks = archetype::chunks_of(values);
+    archetype::chunked_source<int>::view v(chunks);
+    CHECK(archetype::chunked_source<int>::check<decltype(chunks)>::value);
+
+    int buf[3];
+    CHECK(v.next_chunk(buf, 3) == 3);
+    CHECK(buf[2] == 3);
+    CHECK(v.next_chunk(buf, 3) == 3);
+    CHECK(v.next_chunk(buf, 3) == 1);
+    CHECK(buf[0] == 7);
+    CHECK(v.next_chunk(buf, 3) == 0);
+  }
+
+  SUBCASE("per element sources are batched") {
+    countdown c{10};
+    archetype::next_chunks<int, countdown &> chunks(c);
+    archetype::chunked_source<int>::view v(chunks);
+    int sum = 0;
+    CHECK(archetype::for_each_chunked<int, 4>(v, [&](int x) { sum += x; }) == 10);
+    CHECK(sum == 55);
+    CHECK(c.left == 0);
+    CHECK(archetype::for_each_chunked<int, 4>(v, [&](int) { sum++; }) == 0);
+  }
+
+  SUBCASE("null views are empty") {
+    archetype::chunked_source<int>::view v;
+    CHECK(archetype::for_each_chunked<int>(v, [](int) {}) == 0);
+  }
+}
+
+TEST_CASE("allocators") {
+  SUBCASE("monotonic arenas bump through a buffer, then the heap") {
+    alignas(16) char buffer[64];
+    archetype::monotonic_arena arena(buffer, sizeof(buffer), 128);
+    archetype::allocator::view a(arena);
+    void *p = a.allocate(10, 1);
+    void *q = a.allocate(8, 8);
+    CHECK(p == buffer);
+    CHECK(reinterpret_cast<std::uintptr_t>(q) % 8 == 0);
+    CHECK(a.owns(q));
+
+    void *big = a.allocate(100, 16);
+    CHECK(big != nullptr);
+    CHECK(reinterpret_cast<std::uintptr_t>(big) % 16 == 0);
+    CHECK(a.owns(big));
+    CHECK_FALSE(a.owns(&arena));
+
+    arena.release();
+    CHECK_FALSE(a.owns(big));
+    CHECK(a.allocate(10, 1) == buffer);
+  }
+
+  SUBCASE("size class pools reuse freed blocks") {
+    archetype::size_class_pool pool;
+    archetype::allocator::view a(pool);
+    void *p = a.allocate(24, 8);
+    a.deallocate(p, 24, 8);
+    CHECK(a.allocate(30, 8) == p);
+    CHECK(a.owns(p));
+    CHECK(a.allocate(16, 64) == nullptr);
+
+    void *large = a.allocate(4096, 8);
+    CHECK_FALSE(a.owns(large));
+    a.deallocate(large, 4096, 8);
+  }
+
+  SUBCASE("thread caches reuse blocks freed on the same thread") {
+    archetype::thread_cache cache;
+    archetype::allocator::view a(cache);
+    void *p = a.allocate(100, 8);
+    a.deallocate(p, 100, 8);
+    CHECK(a.allocate(128, 8) == p);
+    a.deallocate(p, 128, 8);
+    CHECK(a.owns(p));
+  }
+
+  SUBCASE("STL containers allocate through a view") {
+    archetype::size_class_pool pool;
+    archetype::stl_allocator<int> alloc{archetype::allocator::view(pool)};
+    std::map<int, int, std::less<int>, archetype::stl_allocator<std::pair<const int, int>>>
+        m(alloc);
+    for (int i = 0; i < 100; i++) { m[i] = i * i; }
+    CHECK(m[9] == 81);
+    CHECK(pool.owns(&m.begin()->second));
+
+    std::list<int, archetype::stl_allocator<int>> l(alloc);
+    l.push_back(1);
+    CHECK(alloc == l.get_allocator());
+
+    archetype::monotonic_arena arena;
+    archetype::stl_allocator<int> other{archetype::allocator::view(arena)};
+    CHECK(alloc != other);
+  }
+}
+
+// Test fixtures for the task scheduler
+struct count_task {
+  std::atomic<int> *count;
+  void run() { (*count)++; }
+};
+
+struct fan_out_task {
+  archetype::task_scheduler *scheduler;
+  std::atomic<int> *count;
+  int depth;
+  void run() {
+    (*count)++;
+    if (depth > 0) {
+      scheduler->submit(fan_out_task{scheduler, count, depth - 1});
+      scheduler->submit(fan_out_task{scheduler, count, depth - 1});
+    }
+  }
+};
+
+struct append_task {
+  std::vector<int> *out;
+  int value;
+  void run() { out->push_back(value); }
+};
+
+TEST_CASE("task scheduler") {
+  SUBCASE("every submitted task runs") {
+    std::atomic<int> count(0);
+    archetype::task_scheduler scheduler(4, 8);
+    for (int i = 0; i < 1000; i++) { scheduler.submit(count_task{&count}); }
+    scheduler.wait();
+    CHECK(count == 1000);
+  }
+
+  SUBCASE("tasks submit more tasks") {
+    std::atomic<int> count(0);
+    archetype::task_scheduler scheduler(3);
+    scheduler.submit(fan_out_task{&scheduler, &count, 10});
+    scheduler.wait();
+    CHECK(count == 2047);
+  }
+
+  SUBCASE("chained tasks run in order") {
+    std::vector<int> out;
+    {
+      archetype::task_scheduler scheduler(4);
+      scheduler.submit_chain(append_task{&out, 1}, append_task{&out, 2},
+                             append_task{&out, 3});
+    }
+    CHECK(out == std::vector<int>{1, 2, 3});
+  }
+}
+
+// Test fixtures for relocatable views
+ARCHETYPE_DEFINE(valued, (ARCHETYPE_METHOD(int, value)))
+
+struct leaf_value {
+  int v;
+  int value() { return v; }
+};
+
+struct doubled_value {
+  archetype::relocatable_view<valued> child;
+  int value() { return 2 * child.value(); }
+};
+
+TEST_CASE("relocatable views") {
+  archetype::relocatable_types<valued>::add<leaf_value>(1);
+  archetype::relocatable_types<valued>::add<doubled_value>(2);
+
+  SUBCASE("views survive moving the memory that holds them") {
+    alignas(16) unsigned char region[128];
+    leaf_value *leaf = new (region) leaf_value{21};
+    doubled_value *twice = new (region + 16) doubled_value{};
+    twice->child.bind(*leaf);
+    auto *root = new (region + 64) archetype::relocatable_view<valued>(*twice);
+    CHECK(root->value() == 42);
+    CHECK(root->type_id() == 2);
+
+    alignas(16) unsigned char moved[128];
+    std::memcpy(moved, region, sizeof(region));
+    std::memset(region, 0, sizeof(region));
+    auto *moved_root = reinterpret_cast<archetype::relocatable_view<valued> *>(moved + 64);
+    CHECK(moved_root->value() == 42);
+    CHECK(moved_root->get().value() == 42);
+  }
+
+  SUBCASE("copies point at the same object") {
+    leaf_value leaf{5};
+    archetype::relocatable_view<valued> a(leaf);
+    archetype::relocatable_view<valued> b(a);
+    CHECK(b.value() == 5);
+    leaf.v = 6;
+    CHECK(b.value() == 6);
+  }
+
+  SUBCASE("null views and unknown ids resolve to the null vtable") {
+    archetype::relocatable_view<valued> empty;
+    CHECK_FALSE(empty);
+    CHECK(empty.value() == 0);
+    CHECK(archetype::relocatable_types<valued>::get(200) ==
+          archetype::relocatable_types<valued>::get(0));
+  }
+}
+
+// Test fixtures for bindings kept in one TU, instantiated at the end of
+// this file as another TU would
+ARCHETYPE_DEFINE(labelled, (ARCHETYPE_METHOD(int, label)))
+
+struct remote_label {
+  int label() { return 17; }
+};
+
+namespace remote {
+struct tag {
+  int label() { return 18; }
+};
+} // namespace remote
+
+ARCHETYPE_EXTERN_BINDING(labelled, remote_label)
+ARCHETYPE_EXTERN_BINDING(labelled, remote::tag)
+
+TEST_CASE("extern bindings") {
+  remote_label r;
+  labelled::view v(r);
+  CHECK(v.label() == 17);
+  CHECK(archetype::access::vtbl(v) == archetype::bound_vtable<labelled, remote_label>::get());
+  CHECK(archetype::access::vtbl(v) != archetype::access::vtbl(labelled::view()));
+
+  // compact views bind through the same vtable
+  remote::tag n;
+  archetype::compact_view<labelled> c(n);
+  CHECK(c.label() == 18);
+  CHECK(archetype::access::vtbl(c.to_view()) ==
+        archetype::bound_vtable<labelled, remote::tag>::get());
+}
+
+ARCHETYPE_INSTANTIATE_BINDING(labelled, remote_label)
+ARCHETYPE_INSTANTIATE_BINDING(labelled, remote::tag)
+
+// Test fixtures for memo caches
+ARCHETYPE_DEFINE(estimator, (ARCHETYPE_PURE_METHOD(int, cost, int, std::string),
+                             ARCHETYPE_METHOD(void, set_rate, int)))
+
+struct counting_estimator {
+  int rate = 2;
+  int computed = 0;
+  int cost(int n, std::string s) {
+    computed++;
+    return rate * n + static_cast<int>(s.size());
+  }
+  void set_rate(int r) { rate = r; }
+};
+
+// Shares its address with its first member, an estimator of another type
+struct outer_estimator {
+  counting_estimator inner;
+  int cost(int n, std::string) { return -n; }
+  void set_rate(int) {}
+};
+
+TEST_CASE("memo caches") {
+  SUBCASE("repeat calls skip the computation") {
+    counting_estimator a, b;
+    estimator::view va(a), vb(b);
+    archetype::memo_cache<estimator> cache(64);
+    CHECK(cache.capacity() == 64);
+    CHECK(cache(va).cost(10, "ab") == 22);
+    CHECK(cache(va).cost(10, "ab") == 22);
+    CHECK(cache(va).cost(10, "abc") == 23);
+    CHECK(cache(vb).cost(10, "ab") == 22);
+    CHECK(a.computed == 2);
+    CHECK(b.computed == 1);
+    CHECK(cache.hits() == 1);
+    CHECK(cache.misses() == 3);
+  }
+
+  SUBCASE("bindings of one address are kept apart") {
+    outer_estimator outer;
+    estimator::view vo(outer), vi(outer.inner);
+    REQUIRE(archetype::access::obj(vo) == archetype::access::obj(vi));
+    archetype::memo_cache<estimator> cache;
+    CHECK(cache(vi).cost(10, "ab") == 22);
+    CHECK(cache(vo).cost(10, "ab") == -10);
+    CHECK(cache(vi).cost(10, "ab") == 22);
+    CHECK(outer.inner.computed == 1);
+    CHECK(cache.hits() == 1);
+  }
+
+  SUBCASE("other methods are not cached") {
+    counting_estimator a;
+    archetype::memo_cache<estimator> cache;
+    cache(estimator::view(a)).set_rate(3);
+    CHECK(a.rate == 3);
+    CHECK(cache.hits() + cache.misses() == 0);
+  }
+
+  SUBCASE("invalidation forgets results") {
+    counting_estimator a, b;
+    estimator::view va(a), vb(b);
+    archetype::memo_cache<estimator> cache;
+    CHECK(cache(va).cost(1, "") == 2);
+    CHECK(cache(vb).cost(1, "") == 2);
+    va.set_rate(5);
+    cache.invalidate(va);
+    CHECK(cache(va).cost(1, "") == 5);
+    CHECK(cache(vb).cost(1, "") == 2);
+    CHECK(a.computed == 2);
+    CHECK(b.computed == 1);
+
+    cache.invalidate();
+    CHECK(cache(vb).cost(1, "") == 2);
+    CHECK(b.computed == 2);
+  }
+
+  SUBCASE("the cache is bounded") {
+    counting_estimator a;
+    estimator::view va(a);
+    archetype::memo_cache<estimator> cache(64);
+    for (int i = 0; i < 1000; i++) { cache(va).cost(i, "x"); }
+    CHECK(cache.misses() == 1000);
+    for (int i = 0; i < 1000; i++) { cache(va).cost(i, "x"); }
+    CHECK(a.computed > 1000);
+    CHECK(cache.hits() <= 64);
+  }
+}
@@ -1,6 +1,12 @@
-#include "archetype/archetype.h"
 #include <iostream>
 
+#ifdef ARCHETYPE_MODULE
+#include "archetype/macros.h"
+import archetype;
+#else
+#include "archetype/archetype.h"
+#endif
+
 ARCHETYPE_DEFINE(basic_overload, (ARCHETYPE_METHOD(int, func0, int),
                                   ARCHETYPE_METHOD(double, func0, double)))
 